@@ -84,6 +84,12 @@ impl Player {
         }
     }
 
+    pub fn flush() {
+        unsafe {
+            gp_flush();
+        }
+    }
+
     pub fn set_sources<T: AsRef<Path>>(paths: &[T]) -> PlayerResult<()> {
         let mut cstr_paths = Vec::with_capacity(paths.len());
 
@@ -195,6 +201,8 @@ mod tests {
 
         Player::set_sources(&tracks)?;
 
+        assert_eq!(Player::sources_size(), 3);
+
         Player::play();
 
         std::thread::sleep(std::time::Duration::from_secs(5));
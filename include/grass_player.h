@@ -1,4 +1,6 @@
 #pragma once
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 enum GpResult {
@@ -17,21 +19,292 @@ enum GpSampleRate {
   GP_SAMPLE_RATE_48000 = 48000,
 };
 
+enum GpSourceMode {
+  GP_SOURCE_MODE_FILE = 0,
+  GP_SOURCE_MODE_MAPPED = 1,
+};
+
+enum GpOutputMode {
+  GP_OUTPUT_MODE_DEVICE = 0,
+  GP_OUTPUT_MODE_RENDER = 1,
+  GP_OUTPUT_MODE_NATIVE_RATE = 2,
+  GP_OUTPUT_MODE_ZONES = 3,
+  GP_OUTPUT_MODE_SINK = 4,
+};
+
+enum GpSinkFormat {
+  GP_SINK_FORMAT_FLOAT = 0,
+  GP_SINK_FORMAT_S16 = 1,
+};
+
+enum GpLatencyProfile {
+  GP_LATENCY_PROFILE_BALANCED = 0,
+  GP_LATENCY_PROFILE_LOW_LATENCY = 1,
+  GP_LATENCY_PROFILE_POWER_SAVING = 2,
+  // The first init on a device and sample rate probes buffer sizes on the calling thread and blocks for up
+  // to 5 s; later inits on the same device and rate reuse the result.
+  GP_LATENCY_PROFILE_CALIBRATED = 3,
+};
+
+enum GpCodec {
+  GP_CODEC_UNKNOWN = 0,
+  GP_CODEC_WAV = 1,
+  GP_CODEC_AIFF = 2,
+  GP_CODEC_MP3 = 3,
+  GP_CODEC_OGG = 4,
+  GP_CODEC_FLAC = 5,
+};
+
+enum GpReplayGainMode {
+  GP_REPLAY_GAIN_MODE_OFF = 0,
+  GP_REPLAY_GAIN_MODE_TRACK = 1,
+  GP_REPLAY_GAIN_MODE_ALBUM = 2,
+};
+
+enum GpEventType {
+  GP_EVENT_TYPE_TRACK_CHANGED = 0,
+  GP_EVENT_TYPE_QUEUE_ENDED = 1,
+  GP_EVENT_TYPE_SEEK_COMPLETED = 2,
+  GP_EVENT_TYPE_STREAM_OPEN_FAILED = 3,
+  GP_EVENT_TYPE_POSITION = 4,
+  // The next source was not preloaded or has another sample rate, so it follows with a hard cut.
+  GP_EVENT_TYPE_CROSSFADE_SKIPPED = 5,
+};
+
+struct GpEvent {
+  enum GpEventType type;
+  size_t source_index;
+  double position;
+};
+
+struct GpInitOptions {
+  enum GpSampleRate sample_rate;
+  enum GpOutputMode output_mode;
+  enum GpLatencyProfile latency_profile;
+};
+
+struct GpOutputConfig {
+  uint32_t buffer_ms;
+  uint32_t update_period_ms;
+  uint32_t device_period_ms;
+  uint32_t mixer_buffer;
+  uint32_t update_threads;
+  uint32_t sample_rate;
+  uint32_t latency_ms;
+};
+
+struct GpSourceInfo {
+  double duration;
+  uint32_t sample_rate;
+  uint16_t channels;
+  uint16_t bits_per_sample;
+  enum GpCodec codec;
+};
+
+struct GpScanResult {
+  size_t index;
+  bool valid;
+  struct GpSourceInfo info;
+};
+
+typedef void (* GpScanCallback)(const struct GpScanResult* results, size_t results_size, void* user);
+
+struct GpLoudnessInfo {
+  double integrated_loudness;
+  double true_peak;
+  double loudness_range;
+};
+
+struct GpAnalysisResult {
+  size_t index;
+  bool valid;
+  struct GpLoudnessInfo loudness;
+};
+
+typedef void (* GpAnalysisCallback)(const struct GpAnalysisResult* results, size_t results_size, void* user);
+
+struct GpSnapshot {
+  enum GpPlaybackState playback_state;
+  size_t source_index;
+  size_t sources_size;
+  double source_position;
+  double source_duration;
+  float volume;
+};
+
+struct GpHandoverStats {
+  double seconds;
+  bool preloaded;
+};
+
+struct GpInitStats {
+  double plugin_load_seconds;
+  double device_init_seconds;
+  double mixer_create_seconds;
+  double sync_setup_seconds;
+  double init_seconds;
+  double first_audio_seconds;
+};
+
+struct GpSinkStats {
+  size_t clients;
+  uint64_t skipped_bytes;
+  uint64_t dropped_clients;
+};
+
+struct GpPlayer;
+
+struct GpLevels {
+  float peak[2];
+  float rms[2];
+};
+
 enum GpResult gp_init(enum GpSampleRate sample_rate);
+enum GpResult gp_init_render(enum GpSampleRate sample_rate);
+enum GpResult gp_init_ex(const struct GpInitOptions* options);
 enum GpResult gp_close(void);
+enum GpResult gp_set_plugin_path(const char* path);
+void gp_flush(void);
 
+// Queued; the result only covers argument checks. Getters wait for it.
 enum GpResult gp_set_sources(const char** sources, size_t sources_size);
+// Queued; the result only covers argument checks. Getters wait for it.
+enum GpResult gp_insert_sources(size_t index, const char** sources, size_t sources_size);
+// Queued; the result only covers argument checks. Getters wait for it.
+enum GpResult gp_append_sources(const char** sources, size_t sources_size);
+// Queued; the result only covers argument checks. Getters wait for it.
+enum GpResult gp_remove_sources(size_t index, size_t sources_size);
+// Queued; the result only covers argument checks. Getters wait for it.
+enum GpResult gp_move_source(size_t from_index, size_t to_index);
 enum GpPlaybackState gp_get_playback_state(void);
 size_t gp_get_sources_size(void);
 size_t gp_get_source_index(void);
 const char* gp_get_source_path(void);
 double gp_get_source_position(void);
+uint64_t gp_get_source_position_frames(void);
 double gp_get_source_duration(void);
 float gp_get_volume(void);
+// Queued; getters wait for it.
 void gp_set_volume(float volume);
+// Queued; getters wait for it.
+void gp_set_replay_gain_mode(enum GpReplayGainMode replay_gain_mode);
+// Queued; getters wait for it.
+void gp_set_source_mode(enum GpSourceMode source_mode);
+// Queued; getters wait for it.
+void gp_set_crossfade(double seconds);
+enum GpResult gp_get_handover_stats(struct GpHandoverStats* stats);
+enum GpResult gp_get_init_stats(struct GpInitStats* stats);
+enum GpResult gp_get_snapshot(struct GpSnapshot* snapshot);
+enum GpResult gp_get_output_config(struct GpOutputConfig* config);
+enum GpResult gp_get_source_info(size_t index, struct GpSourceInfo* info);
+enum GpResult gp_open_metadata_cache(const char* path);
+enum GpResult gp_save_metadata_cache(void);
+enum GpResult gp_scan(const char** paths, size_t paths_size, size_t threads_size, GpScanCallback callback,
+		void* user);
+enum GpResult gp_get_source_loudness(size_t index, struct GpLoudnessInfo* loudness);
+enum GpResult gp_analyze(const char** paths, size_t paths_size, size_t threads_size, GpAnalysisCallback callback,
+		void* user);
+enum GpResult gp_get_pcm(float* frames, size_t frames_size);
+enum GpResult gp_get_levels(size_t frames_size, struct GpLevels* levels);
+enum GpResult gp_get_spectrum(float* magnitudes, size_t magnitudes_size);
+// Queued; the result only covers argument checks. Getters wait for it.
+enum GpResult gp_add_zone(int device);
+// Queued; the result only covers argument checks. Getters wait for it.
+enum GpResult gp_remove_zone(size_t index);
+// Queued; the result only covers argument checks. Getters wait for it.
+enum GpResult gp_set_zone_gain(size_t index, float gain);
+// Queued; the result only covers argument checks. Getters wait for it.
+enum GpResult gp_set_zone_latency_offset(size_t index, uint32_t milliseconds);
+size_t gp_get_zones_size(void);
+enum GpResult gp_open_sink(const char* path, enum GpSinkFormat format);
+enum GpResult gp_get_sink_stats(struct GpSinkStats* stats);
+
+bool gp_poll_event(struct GpEvent* event);
+int gp_get_event_fd(void);
+void gp_set_position_interval(double seconds);
 
+// Queued; getters wait for it.
 void gp_play(void);
+// Queued; getters wait for it.
 void gp_stop(void);
+// Queued; getters wait for it.
 void gp_pause(void);
+// Queued; getters wait for it.
 void gp_seek(double seconds);
+// Queued; getters wait for it.
 void gp_skip_to(size_t source_index);
+
+size_t gp_render(float* buffer, size_t frames_size);
+enum GpResult gp_render_to_file(const char* path);
+
+struct GpPlayer* gp_player_create(const struct GpInitOptions* options);
+enum GpResult gp_player_destroy(struct GpPlayer* player);
+void gp_player_flush(struct GpPlayer* player);
+// Queued; the result only covers argument checks. Getters wait for it.
+enum GpResult gp_player_set_sources(struct GpPlayer* player, const char** sources, size_t sources_size);
+// Queued; the result only covers argument checks. Getters wait for it.
+enum GpResult gp_player_insert_sources(struct GpPlayer* player, size_t index, const char** sources,
+		size_t sources_size);
+// Queued; the result only covers argument checks. Getters wait for it.
+enum GpResult gp_player_append_sources(struct GpPlayer* player, const char** sources, size_t sources_size);
+// Queued; the result only covers argument checks. Getters wait for it.
+enum GpResult gp_player_remove_sources(struct GpPlayer* player, size_t index, size_t sources_size);
+// Queued; the result only covers argument checks. Getters wait for it.
+enum GpResult gp_player_move_source(struct GpPlayer* player, size_t from_index, size_t to_index);
+enum GpPlaybackState gp_player_get_playback_state(struct GpPlayer* player);
+size_t gp_player_get_sources_size(struct GpPlayer* player);
+size_t gp_player_get_source_index(struct GpPlayer* player);
+size_t gp_player_get_source_path(struct GpPlayer* player, char* path, size_t path_size);
+double gp_player_get_source_position(struct GpPlayer* player);
+uint64_t gp_player_get_source_position_frames(struct GpPlayer* player);
+double gp_player_get_source_duration(struct GpPlayer* player);
+float gp_player_get_volume(struct GpPlayer* player);
+// Queued; getters wait for it.
+void gp_player_set_volume(struct GpPlayer* player, float volume);
+// Queued; getters wait for it.
+void gp_player_set_replay_gain_mode(struct GpPlayer* player, enum GpReplayGainMode replay_gain_mode);
+// Queued; getters wait for it.
+void gp_player_set_source_mode(struct GpPlayer* player, enum GpSourceMode source_mode);
+// Queued; getters wait for it.
+void gp_player_set_crossfade(struct GpPlayer* player, double seconds);
+enum GpResult gp_player_get_handover_stats(struct GpPlayer* player, struct GpHandoverStats* stats);
+enum GpResult gp_player_get_init_stats(struct GpPlayer* player, struct GpInitStats* stats);
+enum GpResult gp_player_get_snapshot(struct GpPlayer* player, struct GpSnapshot* snapshot);
+enum GpResult gp_player_get_output_config(struct GpPlayer* player, struct GpOutputConfig* config);
+enum GpResult gp_player_get_source_info(struct GpPlayer* player, size_t index, struct GpSourceInfo* info);
+enum GpResult gp_player_open_metadata_cache(struct GpPlayer* player, const char* path);
+enum GpResult gp_player_save_metadata_cache(struct GpPlayer* player);
+enum GpResult gp_player_scan(struct GpPlayer* player, const char** paths, size_t paths_size, size_t threads_size,
+		GpScanCallback callback, void* user);
+enum GpResult gp_player_get_source_loudness(struct GpPlayer* player, size_t index, struct GpLoudnessInfo* loudness);
+enum GpResult gp_player_analyze(struct GpPlayer* player, const char** paths, size_t paths_size, size_t threads_size,
+		GpAnalysisCallback callback, void* user);
+enum GpResult gp_player_get_pcm(struct GpPlayer* player, float* frames, size_t frames_size);
+enum GpResult gp_player_get_levels(struct GpPlayer* player, size_t frames_size, struct GpLevels* levels);
+enum GpResult gp_player_get_spectrum(struct GpPlayer* player, float* magnitudes, size_t magnitudes_size);
+// Queued; the result only covers argument checks. Getters wait for it.
+enum GpResult gp_player_add_zone(struct GpPlayer* player, int device);
+// Queued; the result only covers argument checks. Getters wait for it.
+enum GpResult gp_player_remove_zone(struct GpPlayer* player, size_t index);
+// Queued; the result only covers argument checks. Getters wait for it.
+enum GpResult gp_player_set_zone_gain(struct GpPlayer* player, size_t index, float gain);
+// Queued; the result only covers argument checks. Getters wait for it.
+enum GpResult gp_player_set_zone_latency_offset(struct GpPlayer* player, size_t index, uint32_t milliseconds);
+size_t gp_player_get_zones_size(struct GpPlayer* player);
+enum GpResult gp_player_open_sink(struct GpPlayer* player, const char* path, enum GpSinkFormat format);
+enum GpResult gp_player_get_sink_stats(struct GpPlayer* player, struct GpSinkStats* stats);
+bool gp_player_poll_event(struct GpPlayer* player, struct GpEvent* event);
+int gp_player_get_event_fd(struct GpPlayer* player);
+void gp_player_set_position_interval(struct GpPlayer* player, double seconds);
+// Queued; getters wait for it.
+void gp_player_play(struct GpPlayer* player);
+// Queued; getters wait for it.
+void gp_player_stop(struct GpPlayer* player);
+// Queued; getters wait for it.
+void gp_player_pause(struct GpPlayer* player);
+// Queued; getters wait for it.
+void gp_player_seek(struct GpPlayer* player, double seconds);
+// Queued; getters wait for it.
+void gp_player_skip_to(struct GpPlayer* player, size_t source_index);
+size_t gp_player_render(struct GpPlayer* player, float* buffer, size_t frames_size);
+enum GpResult gp_player_render_to_file(struct GpPlayer* player, const char* path);
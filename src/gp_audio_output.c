@@ -1,31 +1,326 @@
 #include "gp_audio_output.h"
+#include <stdatomic.h>
+#include <threads.h>
 #include "bass.h"
+#include "bassmix.h"
+#include "gp_clock.h"
+#include "gp_plugin.h"
 
-static struct Plugin plugins[] = {
-		{"./bassflac.dll", 0}
+static const struct GpOutputConfig latency_profiles[] = {
+		[GP_LATENCY_PROFILE_BALANCED] = {500, 100, 0, 2, 1},
+		[GP_LATENCY_PROFILE_LOW_LATENCY] = {20, 5, 3, 1, 1},
+		[GP_LATENCY_PROFILE_POWER_SAVING] = {2000, 100, 40, 2, 1},
+		[GP_LATENCY_PROFILE_CALIBRATED] = {100, 25, 3, 1, 1},
 };
 
-static uint8_t plugins_size = sizeof(plugins) / sizeof(struct Plugin);
+static const uint32_t calibration_buffers[] = {100, 80, 60, 50, 40, 30, 25, 20, 15, 10};
 
-enum GpResult gp_audio_output_init(enum GpSampleRate sample_rate) {
-	for (uint8_t i = 0; i < plugins_size; i++) {
-		plugins[i].handle = BASS_PluginLoad(plugins[i].path, 0);
-		if (plugins[i].handle == 0) return GP_RESULT_ERROR;
+static struct GpOutputConfig output_config;
+static struct GpOutputConfig calibrated_config;
+static int calibrated_device = GP_AUDIO_OUTPUT_NO_SOUND_DEVICE;
+static int output_device = GP_AUDIO_OUTPUT_NO_SOUND_DEVICE;
+static bool output_native_rate;
+static enum GpLatencyProfile output_latency_profile;
+static bool no_sound_open = false;
+static size_t output_references = 0;
+static _Atomic uint32_t output_latency_ms;
+static mtx_t output_mutex;
+static size_t device_references[GP_AUDIO_OUTPUT_MAX_DEVICES];
+static bool device_owned[GP_AUDIO_OUTPUT_MAX_DEVICES];
+static once_flag output_once = ONCE_FLAG_INIT;
+
+static void init_output_mutex(void) {
+	mtx_init(&output_mutex, mtx_plain);
+}
+
+static void apply_config(const struct GpOutputConfig* config) {
+	BASS_SetConfig(BASS_CONFIG_BUFFER, config->buffer_ms);
+	BASS_SetConfig(BASS_CONFIG_UPDATEPERIOD, config->update_period_ms);
+	BASS_SetConfig(BASS_CONFIG_MIXER_BUFFER, config->mixer_buffer);
+	BASS_SetConfig(BASS_CONFIG_UPDATETHREADS, config->update_threads);
+}
+
+static void CALLBACK handle_stall_sync(HSYNC sync, DWORD channel, DWORD data, void* user) {
+	(void)sync;
+	(void)channel;
+	if (data == 0) atomic_fetch_add((atomic_uint*)user, 1);
+}
+
+static bool has_underruns(uint32_t sample_rate) {
+	atomic_uint stalls = 0;
+
+	uint32_t mixer_stream_handle = BASS_Mixer_StreamCreate(sample_rate, 2, BASS_MIXER_NONSTOP);
+	if (mixer_stream_handle == 0) return true;
+
+	BASS_ChannelSetSync(mixer_stream_handle, BASS_SYNC_STALL | BASS_SYNC_MIXTIME, 0, &handle_stall_sync, &stalls);
+	BASS_ChannelPlay(mixer_stream_handle, FALSE);
+
+	struct timespec step = {0, (long)(GP_CALIBRATION_STEP_SECONDS * 1e9)};
+	thrd_sleep(&step, NULL);
+
+	BASS_StreamFree(mixer_stream_handle);
+
+	return atomic_load(&stalls) > 0;
+}
+
+static void calibrate(uint32_t sample_rate, uint32_t min_buffer_ms) {
+	size_t calibration_buffers_size = sizeof(calibration_buffers) / sizeof(calibration_buffers[0]);
+	uint32_t stable_buffer_ms = calibration_buffers[0];
+
+	for (size_t i = 0; i < calibration_buffers_size; i++) {
+		uint32_t buffer_ms = calibration_buffers[i];
+		uint32_t update_period_ms = buffer_ms / 4 < 5 ? 5 : buffer_ms / 4;
+		if (buffer_ms < min_buffer_ms + update_period_ms) break;
+
+		output_config.buffer_ms = buffer_ms;
+		output_config.update_period_ms = update_period_ms;
+		apply_config(&output_config);
+
+		if (has_underruns(sample_rate)) break;
+		stable_buffer_ms = buffer_ms;
 	}
 
-	if (!BASS_Init(-1, sample_rate, 0, NULL, NULL)) return GP_RESULT_ERROR;
+	output_config.buffer_ms = (uint32_t)(stable_buffer_ms * GP_CALIBRATION_HEADROOM);
+	output_config.update_period_ms = output_config.buffer_ms / 4 < 5 ? 5 : output_config.buffer_ms / 4;
+	if (output_config.update_period_ms > 100) output_config.update_period_ms = 100;
+	apply_config(&output_config);
+
+	calibrated_config = output_config;
+	calibrated_device = output_device;
+}
+
+static enum GpResult open_output(int device, uint32_t sample_rate, bool native_rate,
+		enum GpLatencyProfile latency_profile, double* init_seconds) {
+	if (latency_profile > GP_LATENCY_PROFILE_CALIBRATED) return GP_RESULT_ERROR;
+	output_config = latency_profiles[latency_profile];
+	output_config.sample_rate = sample_rate;
+
+	BASS_SetConfig(BASS_CONFIG_DEV_PERIOD, output_config.device_period_ms);
+
+	uint32_t flags = BASS_DEVICE_LATENCY | (native_rate ? BASS_DEVICE_FREQ : 0);
+	double init_start = gp_clock_now();
+	if (BASS_Init(device, sample_rate, flags, NULL, NULL)) {
+		output_device = (int)BASS_GetDevice();
+	} else if (BASS_ErrorGetCode() == BASS_ERROR_ALREADY && device > GP_AUDIO_OUTPUT_NO_SOUND_DEVICE
+			&& device < GP_AUDIO_OUTPUT_MAX_DEVICES && device_owned[device]) {
+		device_owned[device] = false;
+		output_device = device;
+		BASS_SetDevice(device);
+	} else {
+		return GP_RESULT_ERROR;
+	}
+	*init_seconds = gp_clock_now() - init_start;
+	output_native_rate = native_rate;
+	output_latency_profile = latency_profile;
+
+	if (device == GP_AUDIO_OUTPUT_NO_SOUND_DEVICE) {
+		no_sound_open = true;
+		return GP_RESULT_OK;
+	}
+
+	BASS_INFO info;
+	uint32_t min_buffer_ms = 0;
+	if (BASS_GetInfo(&info)) {
+		min_buffer_ms = info.minbuf;
+		output_config.latency_ms = info.latency;
+	}
+
+	if (latency_profile == GP_LATENCY_PROFILE_CALIBRATED) {
+		if (calibrated_device == output_device && calibrated_config.sample_rate == sample_rate) {
+			output_config.buffer_ms = calibrated_config.buffer_ms;
+			output_config.update_period_ms = calibrated_config.update_period_ms;
+			apply_config(&output_config);
+		} else {
+			calibrate(sample_rate, min_buffer_ms);
+		}
+		return GP_RESULT_OK;
+	}
+
+	if (output_config.buffer_ms < min_buffer_ms + output_config.update_period_ms) {
+		output_config.buffer_ms = min_buffer_ms + output_config.update_period_ms;
+	}
+	apply_config(&output_config);
 
 	return GP_RESULT_OK;
+}
+
+static int resolve_device(int device) {
+	if (device != GP_AUDIO_OUTPUT_DEFAULT_DEVICE) return device;
+
+	BASS_DEVICEINFO info;
+	for (int i = 1; BASS_GetDeviceInfo(i, &info); i++) {
+		if ((info.flags & BASS_DEVICE_DEFAULT) != 0) return i;
+	}
 
+	return GP_AUDIO_OUTPUT_NO_SOUND_DEVICE;
 }
 
-enum GpResult gp_audio_output_close(void) {
-	for (uint8_t i = 0; i < plugins_size; i++) {
-		if (!BASS_PluginFree(plugins[i].handle)) return GP_RESULT_ERROR;
-		plugins[i].handle = 0;
+static enum GpResult share_output(int device, uint32_t sample_rate, bool native_rate,
+		enum GpLatencyProfile latency_profile, double* init_seconds) {
+	if (device == GP_AUDIO_OUTPUT_NO_SOUND_DEVICE) {
+		if (no_sound_open || output_device == GP_AUDIO_OUTPUT_NO_SOUND_DEVICE) return GP_RESULT_OK;
+		if (!BASS_Init(GP_AUDIO_OUTPUT_NO_SOUND_DEVICE, sample_rate, 0, NULL, NULL)
+				&& BASS_ErrorGetCode() != BASS_ERROR_ALREADY) {
+			return GP_RESULT_ERROR;
+		}
+		no_sound_open = true;
+		return GP_RESULT_OK;
+	}
+	if (native_rate || output_native_rate) return GP_RESULT_ERROR;
+
+	if (output_device == GP_AUDIO_OUTPUT_NO_SOUND_DEVICE) {
+		device = resolve_device(device);
+		if (device <= GP_AUDIO_OUTPUT_NO_SOUND_DEVICE || device >= GP_AUDIO_OUTPUT_MAX_DEVICES) return GP_RESULT_ERROR;
+
+		struct GpOutputConfig previous_config = output_config;
+		if (open_output(device, sample_rate, native_rate, latency_profile, init_seconds) == GP_RESULT_OK) {
+			return GP_RESULT_OK;
+		}
+
+		output_config = previous_config;
+		apply_config(&output_config);
+		return GP_RESULT_ERROR;
+	}
+
+	if (sample_rate != output_config.sample_rate || latency_profile != output_latency_profile) return GP_RESULT_ERROR;
+
+	BASS_SetDevice(output_device);
+
+	return GP_RESULT_OK;
+}
+
+enum GpResult gp_audio_output_init(int device, uint32_t sample_rate, bool native_rate,
+		enum GpLatencyProfile latency_profile, double* init_seconds) {
+	call_once(&output_once, init_output_mutex);
+	mtx_lock(&output_mutex);
+
+	*init_seconds = 0;
+	enum GpResult result = output_references > 0
+			? share_output(device, sample_rate, native_rate, latency_profile, init_seconds)
+			: open_output(device, sample_rate, native_rate, latency_profile, init_seconds);
+	if (result == GP_RESULT_OK) output_references++;
+	atomic_store_explicit(&output_latency_ms, output_config.latency_ms, memory_order_relaxed);
+
+	mtx_unlock(&output_mutex);
+
+	return result;
+}
+
+enum GpResult gp_audio_output_set_sample_rate(uint32_t sample_rate) {
+	call_once(&output_once, init_output_mutex);
+	mtx_lock(&output_mutex);
+
+	if (!BASS_Init(output_device, sample_rate, BASS_DEVICE_REINIT | BASS_DEVICE_FREQ | BASS_DEVICE_LATENCY, NULL,
+			NULL)) {
+		mtx_unlock(&output_mutex);
+		return GP_RESULT_ERROR;
 	}
 
+	output_config.sample_rate = sample_rate;
+
+	BASS_INFO info;
+	if (BASS_GetInfo(&info)) output_config.latency_ms = info.latency;
+	atomic_store_explicit(&output_latency_ms, output_config.latency_ms, memory_order_relaxed);
+
+	mtx_unlock(&output_mutex);
+
+	return GP_RESULT_OK;
+}
+
+static enum GpResult close_output(void) {
+	if (gp_plugin_free_all() != GP_RESULT_OK) return GP_RESULT_ERROR;
+
+	BASS_SetDevice(output_device);
 	if (!BASS_Free()) return GP_RESULT_ERROR;
 
+	if (no_sound_open && output_device != GP_AUDIO_OUTPUT_NO_SOUND_DEVICE) {
+		BASS_SetDevice(GP_AUDIO_OUTPUT_NO_SOUND_DEVICE);
+		if (!BASS_Free()) return GP_RESULT_ERROR;
+	}
+	no_sound_open = false;
+	output_device = GP_AUDIO_OUTPUT_NO_SOUND_DEVICE;
+
 	return GP_RESULT_OK;
 }
+
+enum GpResult gp_audio_output_close(void) {
+	call_once(&output_once, init_output_mutex);
+	mtx_lock(&output_mutex);
+
+	enum GpResult result = GP_RESULT_OK;
+	if (output_references == 0) result = GP_RESULT_ERROR;
+	else if (--output_references == 0) result = close_output();
+
+	mtx_unlock(&output_mutex);
+
+	return result;
+}
+
+void gp_audio_output_get_config(struct GpOutputConfig* config) {
+	call_once(&output_once, init_output_mutex);
+	mtx_lock(&output_mutex);
+	*config = output_config;
+	mtx_unlock(&output_mutex);
+}
+
+void gp_audio_output_select_device(bool no_sound) {
+	call_once(&output_once, init_output_mutex);
+	mtx_lock(&output_mutex);
+	BASS_SetDevice(no_sound ? GP_AUDIO_OUTPUT_NO_SOUND_DEVICE : (DWORD)output_device);
+	mtx_unlock(&output_mutex);
+}
+
+uint32_t gp_audio_output_get_latency_ms(void) {
+	return atomic_load_explicit(&output_latency_ms, memory_order_relaxed);
+}
+
+enum GpResult gp_audio_output_acquire_device(int device, int* device_handle, uint32_t* latency_ms) {
+	call_once(&output_once, init_output_mutex);
+	mtx_lock(&output_mutex);
+
+	device = resolve_device(device);
+	if (output_references == 0 || device <= GP_AUDIO_OUTPUT_NO_SOUND_DEVICE
+			|| device >= GP_AUDIO_OUTPUT_MAX_DEVICES) {
+		mtx_unlock(&output_mutex);
+		return GP_RESULT_ERROR;
+	}
+
+	if (device_references[device] == 0) {
+		if (BASS_Init(device, output_config.sample_rate, BASS_DEVICE_LATENCY, NULL, NULL)) {
+			device_owned[device] = true;
+			apply_config(&output_config);
+		} else if (BASS_ErrorGetCode() != BASS_ERROR_ALREADY) {
+			BASS_SetDevice(output_device);
+			mtx_unlock(&output_mutex);
+			return GP_RESULT_ERROR;
+		}
+	}
+
+	BASS_INFO info;
+	BASS_SetDevice(device);
+	*latency_ms = BASS_GetInfo(&info) ? info.latency : 0;
+	BASS_SetDevice(output_device);
+
+	device_references[device]++;
+	*device_handle = device;
+
+	mtx_unlock(&output_mutex);
+
+	return GP_RESULT_OK;
+}
+
+void gp_audio_output_release_device(int device_handle) {
+	call_once(&output_once, init_output_mutex);
+	mtx_lock(&output_mutex);
+
+	if (device_handle > GP_AUDIO_OUTPUT_NO_SOUND_DEVICE && device_handle < GP_AUDIO_OUTPUT_MAX_DEVICES
+			&& device_references[device_handle] > 0 && --device_references[device_handle] == 0
+			&& device_owned[device_handle]) {
+		BASS_SetDevice(device_handle);
+		BASS_Free();
+		BASS_SetDevice(output_device);
+		device_owned[device_handle] = false;
+	}
+
+	mtx_unlock(&output_mutex);
+}
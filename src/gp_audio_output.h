@@ -1,10 +1,19 @@
 #pragma once
+#include <stdbool.h>
 #include "grass_player.h"
 
-struct Plugin {
-  const char* path;
-  uint32_t handle;
-};
+#define GP_AUDIO_OUTPUT_DEFAULT_DEVICE (-1)
+#define GP_AUDIO_OUTPUT_NO_SOUND_DEVICE 0
+#define GP_AUDIO_OUTPUT_MAX_DEVICES 32
+#define GP_CALIBRATION_STEP_SECONDS 0.5
+#define GP_CALIBRATION_HEADROOM 1.5
 
-enum GpResult gp_audio_output_init(enum GpSampleRate sample_rate);
+enum GpResult gp_audio_output_init(int device, uint32_t sample_rate, bool native_rate,
+		enum GpLatencyProfile latency_profile, double* init_seconds);
+enum GpResult gp_audio_output_set_sample_rate(uint32_t sample_rate);
 enum GpResult gp_audio_output_close(void);
+void gp_audio_output_get_config(struct GpOutputConfig* config);
+uint32_t gp_audio_output_get_latency_ms(void);
+void gp_audio_output_select_device(bool no_sound);
+enum GpResult gp_audio_output_acquire_device(int device, int* device_handle, uint32_t* latency_ms);
+void gp_audio_output_release_device(int device_handle);
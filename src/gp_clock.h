@@ -0,0 +1,3 @@
+#pragma once
+
+double gp_clock_now(void);
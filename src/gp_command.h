@@ -0,0 +1,67 @@
+#pragma once
+#include <stddef.h>
+#include "grass_player.h"
+#include "gp_source_list.h"
+#include "gp_zone.h"
+
+#define GP_COMMAND_QUEUE_CAPACITY 1024
+
+enum GpCommandType {
+  GP_COMMAND_QUIT,
+  GP_COMMAND_SET_SOURCES,
+  GP_COMMAND_INSERT_SOURCES,
+  GP_COMMAND_REMOVE_SOURCES,
+  GP_COMMAND_MOVE_SOURCE,
+  GP_COMMAND_PLAY,
+  GP_COMMAND_STOP,
+  GP_COMMAND_PAUSE,
+  GP_COMMAND_SEEK,
+  GP_COMMAND_SKIP_TO,
+  GP_COMMAND_SET_VOLUME,
+  GP_COMMAND_SET_REPLAY_GAIN_MODE,
+  GP_COMMAND_SET_SOURCE_MODE,
+  GP_COMMAND_SET_CROSSFADE,
+  GP_COMMAND_ADD_ZONE,
+  GP_COMMAND_REMOVE_ZONE,
+  GP_COMMAND_SET_ZONE_GAIN,
+  GP_COMMAND_SET_ZONE_LATENCY_OFFSET,
+};
+
+enum GpRequest {
+  GP_REQUEST_PRELOAD = 1 << 0,
+  GP_REQUEST_ADVANCE = 1 << 1,
+};
+
+struct GpCommand {
+  enum GpCommandType type;
+  union {
+    struct GpSourceList* sources;
+    struct {
+      size_t index;
+      struct GpSourceList* sources;
+    } insert;
+    struct {
+      size_t index;
+      size_t size;
+    } remove;
+    struct {
+      size_t from_index;
+      size_t to_index;
+    } move;
+    double seconds;
+    size_t source_index;
+    float volume;
+    enum GpReplayGainMode replay_gain_mode;
+    enum GpSourceMode source_mode;
+    struct GpZone* zone;
+    size_t zone_index;
+    struct {
+      size_t index;
+      float gain;
+    } zone_gain;
+    struct {
+      size_t index;
+      uint32_t milliseconds;
+    } zone_latency_offset;
+  };
+};
@@ -0,0 +1,57 @@
+#include "gp_event.h"
+#ifdef __linux__
+#include <stdint.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+enum GpResult gp_event_queue_init(struct GpEventQueue* event_queue) {
+	if (gp_ring_init(&event_queue->events, GP_EVENT_QUEUE_CAPACITY, sizeof(struct GpEvent)) != GP_RESULT_OK) {
+		return GP_RESULT_ERROR;
+	}
+
+#ifdef __linux__
+	event_queue->fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (event_queue->fd == -1) {
+		gp_ring_destroy(&event_queue->events);
+		return GP_RESULT_ERROR;
+	}
+#else
+	event_queue->fd = -1;
+#endif
+
+	return GP_RESULT_OK;
+}
+
+void gp_event_queue_destroy(struct GpEventQueue* event_queue) {
+#ifdef __linux__
+	if (event_queue->fd != -1) close(event_queue->fd);
+#endif
+	event_queue->fd = -1;
+	gp_ring_destroy(&event_queue->events);
+}
+
+bool gp_event_queue_push(struct GpEventQueue* event_queue, const struct GpEvent* event) {
+	if (!gp_ring_push(&event_queue->events, event)) return false;
+
+#ifdef __linux__
+	uint64_t value = 1;
+	ssize_t written_size = write(event_queue->fd, &value, sizeof(value));
+	(void)written_size;
+#endif
+
+	return true;
+}
+
+bool gp_event_queue_pop(struct GpEventQueue* event_queue, struct GpEvent* event) {
+	if (gp_ring_pop(&event_queue->events, event)) return true;
+
+#ifdef __linux__
+	uint64_t value;
+	if (read(event_queue->fd, &value, sizeof(value)) != sizeof(value)) return false;
+
+	return gp_ring_pop(&event_queue->events, event);
+#else
+	return false;
+#endif
+}
@@ -0,0 +1,16 @@
+#pragma once
+#include <stdbool.h>
+#include "grass_player.h"
+#include "gp_ring.h"
+
+#define GP_EVENT_QUEUE_CAPACITY 256
+
+struct GpEventQueue {
+  struct GpRing events;
+  int fd;
+};
+
+enum GpResult gp_event_queue_init(struct GpEventQueue* event_queue);
+void gp_event_queue_destroy(struct GpEventQueue* event_queue);
+bool gp_event_queue_push(struct GpEventQueue* event_queue, const struct GpEvent* event);
+bool gp_event_queue_pop(struct GpEventQueue* event_queue, struct GpEvent* event);
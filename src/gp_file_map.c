@@ -0,0 +1,171 @@
+#include "gp_file_map.h"
+#include <stdlib.h>
+#include <string.h>
+#include "bass.h"
+#include "gp_plugin.h"
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static void advise_readahead(struct GpFileMap* file_map) {
+#ifndef _WIN32
+	if (file_map->access != GP_FILE_MAP_ACCESS_SEQUENTIAL
+			|| file_map->position + GP_FILE_MAP_READAHEAD_SIZE / 2 < file_map->advised_position) {
+		return;
+	}
+
+	uint64_t page_size = (uint64_t)sysconf(_SC_PAGESIZE);
+	uint64_t start = file_map->position & ~(page_size - 1);
+	if (start >= file_map->size) return;
+
+	uint64_t length = file_map->size - start;
+	if (length > GP_FILE_MAP_READAHEAD_SIZE) length = GP_FILE_MAP_READAHEAD_SIZE;
+
+	madvise((void*)(file_map->data + start), length, MADV_WILLNEED);
+	file_map->advised_position = start + length;
+#else
+	(void)file_map;
+#endif
+}
+
+static void CALLBACK handle_file_close(void* user) {
+	gp_file_map_close(user);
+}
+
+static QWORD CALLBACK handle_file_length(void* user) {
+	struct GpFileMap* file_map = user;
+	return file_map->size;
+}
+
+static DWORD CALLBACK handle_file_read(void* buffer, DWORD length, void* user) {
+	struct GpFileMap* file_map = user;
+	if (file_map->position >= file_map->size) return 0;
+
+	uint64_t available = file_map->size - file_map->position;
+	if (length > available) length = (DWORD)available;
+
+	memcpy(buffer, file_map->data + file_map->position, length);
+	file_map->position += length;
+	advise_readahead(file_map);
+
+	return length;
+}
+
+static BOOL CALLBACK handle_file_seek(QWORD offset, void* user) {
+	struct GpFileMap* file_map = user;
+	if (offset > file_map->size) return FALSE;
+
+	file_map->position = offset;
+	file_map->advised_position = 0;
+	advise_readahead(file_map);
+
+	return TRUE;
+}
+
+static const BASS_FILEPROCS file_procs = {
+		handle_file_close,
+		handle_file_length,
+		handle_file_read,
+		handle_file_seek
+};
+
+struct GpFileMap* gp_file_map_open(const struct GpSource* source, enum GpFileMapAccess access) {
+	struct GpFileMap* file_map = malloc(sizeof(struct GpFileMap));
+	if (file_map == NULL) return NULL;
+
+	file_map->position = 0;
+	file_map->advised_position = 0;
+	file_map->access = access;
+
+#ifdef _WIN32
+	const wchar_t* native_path = gp_source_native_path(source);
+	if (native_path == NULL) {
+		free(file_map);
+		return NULL;
+	}
+
+	file_map->file = CreateFileW(native_path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+			access == GP_FILE_MAP_ACCESS_SEQUENTIAL ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_FLAG_RANDOM_ACCESS, NULL);
+	gp_source_free_native_path(source, native_path);
+	if (file_map->file == INVALID_HANDLE_VALUE) {
+		free(file_map);
+		return NULL;
+	}
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file_map->file, &size) || size.QuadPart == 0) {
+		CloseHandle(file_map->file);
+		free(file_map);
+		return NULL;
+	}
+	file_map->size = (uint64_t)size.QuadPart;
+
+	file_map->mapping = CreateFileMappingW(file_map->file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (file_map->mapping == NULL) {
+		CloseHandle(file_map->file);
+		free(file_map);
+		return NULL;
+	}
+
+	file_map->data = MapViewOfFile(file_map->mapping, FILE_MAP_READ, 0, 0, 0);
+	if (file_map->data == NULL) {
+		CloseHandle(file_map->mapping);
+		CloseHandle(file_map->file);
+		free(file_map);
+		return NULL;
+	}
+#else
+	int file = open(source->path, O_RDONLY);
+	if (file < 0) {
+		free(file_map);
+		return NULL;
+	}
+
+	struct stat file_stat;
+	if (fstat(file, &file_stat) != 0 || file_stat.st_size == 0) {
+		close(file);
+		free(file_map);
+		return NULL;
+	}
+	file_map->size = (uint64_t)file_stat.st_size;
+
+	void* data = mmap(NULL, file_map->size, PROT_READ, MAP_PRIVATE, file, 0);
+	close(file);
+	if (data == MAP_FAILED) {
+		free(file_map);
+		return NULL;
+	}
+
+	madvise(data, file_map->size, access == GP_FILE_MAP_ACCESS_SEQUENTIAL ? MADV_SEQUENTIAL : MADV_RANDOM);
+	file_map->data = data;
+#endif
+
+	advise_readahead(file_map);
+
+	return file_map;
+}
+
+void gp_file_map_close(struct GpFileMap* file_map) {
+	if (file_map == NULL) return;
+
+#ifdef _WIN32
+	UnmapViewOfFile(file_map->data);
+	CloseHandle(file_map->mapping);
+	CloseHandle(file_map->file);
+#else
+	munmap((void*)file_map->data, file_map->size);
+#endif
+
+	free(file_map);
+}
+
+uint32_t gp_file_map_create_stream(struct GpFileMap* file_map, uint32_t flags) {
+	gp_plugin_prepare(file_map->data, (size_t)file_map->size);
+
+	return BASS_StreamCreateFileUser(STREAMFILE_NOBUFFER, flags, &file_procs, file_map);
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <stdint.h>
+#include "gp_source.h"
+
+#define GP_FILE_MAP_READAHEAD_SIZE (1024 * 1024)
+
+enum GpFileMapAccess {
+  GP_FILE_MAP_ACCESS_SEQUENTIAL = 0,
+  GP_FILE_MAP_ACCESS_RANDOM = 1,
+};
+
+struct GpFileMap {
+  const uint8_t* data;
+  uint64_t size;
+  uint64_t position;
+  uint64_t advised_position;
+  enum GpFileMapAccess access;
+#ifdef _WIN32
+  void* file;
+  void* mapping;
+#endif
+};
+
+struct GpFileMap* gp_file_map_open(const struct GpSource* source, enum GpFileMapAccess access);
+void gp_file_map_close(struct GpFileMap* file_map);
+uint32_t gp_file_map_create_stream(struct GpFileMap* file_map, uint32_t flags);
@@ -0,0 +1,272 @@
+#include "gp_gain.h"
+#include <float.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bass.h"
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__)
+#define GP_GAIN_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define GP_TARGET_AVX2
+#else
+#define GP_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define GP_GAIN_NEON
+#include <arm_neon.h>
+#endif
+
+float gp_gain_apply_scalar(const float* source, float* destination, size_t frames, float gain, float gain_step) {
+	float peak = 0;
+
+	for (size_t i = 0; i < frames; i++) {
+		float frame_gain = gain + gain_step * (float)i;
+		for (size_t channel = 0; channel < GP_GAIN_CHANNELS; channel++) {
+			float sample = source[i * GP_GAIN_CHANNELS + channel] * frame_gain;
+			destination[i * GP_GAIN_CHANNELS + channel] = sample;
+			if (fabsf(sample) > peak) peak = fabsf(sample);
+		}
+	}
+
+	return peak;
+}
+
+#ifdef GP_GAIN_X86
+static float apply_sse2(const float* source, float* destination, size_t frames, float gain, float gain_step) {
+	__m128 gains = _mm_set1_ps(gain);
+	__m128 gain_steps = _mm_set1_ps(gain_step);
+	__m128 indexes = _mm_setr_ps(0, 0, 1, 1);
+	__m128 index_step = _mm_set1_ps(2);
+	__m128 sign = _mm_set1_ps(-0.0f);
+	__m128 peaks = _mm_setzero_ps();
+
+	size_t i = 0;
+	for (; i + 2 <= frames; i += 2) {
+		__m128 samples = _mm_mul_ps(_mm_loadu_ps(source + i * 2),
+				_mm_add_ps(gains, _mm_mul_ps(gain_steps, indexes)));
+		_mm_storeu_ps(destination + i * 2, samples);
+		peaks = _mm_max_ps(peaks, _mm_andnot_ps(sign, samples));
+		indexes = _mm_add_ps(indexes, index_step);
+	}
+
+	peaks = _mm_max_ps(peaks, _mm_movehl_ps(peaks, peaks));
+	peaks = _mm_max_ss(peaks, _mm_shuffle_ps(peaks, peaks, 1));
+	float peak = _mm_cvtss_f32(peaks);
+
+	float tail_peak = gp_gain_apply_scalar(source + i * 2, destination + i * 2, frames - i,
+			gain + gain_step * (float)i, gain_step);
+
+	return tail_peak > peak ? tail_peak : peak;
+}
+
+GP_TARGET_AVX2
+static float apply_avx2(const float* source, float* destination, size_t frames, float gain, float gain_step) {
+	__m256 gains = _mm256_set1_ps(gain);
+	__m256 gain_steps = _mm256_set1_ps(gain_step);
+	__m256 indexes = _mm256_setr_ps(0, 0, 1, 1, 2, 2, 3, 3);
+	__m256 index_step = _mm256_set1_ps(4);
+	__m256 sign = _mm256_set1_ps(-0.0f);
+	__m256 peaks = _mm256_setzero_ps();
+
+	size_t i = 0;
+	for (; i + 4 <= frames; i += 4) {
+		__m256 samples = _mm256_mul_ps(_mm256_loadu_ps(source + i * 2),
+				_mm256_add_ps(gains, _mm256_mul_ps(gain_steps, indexes)));
+		_mm256_storeu_ps(destination + i * 2, samples);
+		peaks = _mm256_max_ps(peaks, _mm256_andnot_ps(sign, samples));
+		indexes = _mm256_add_ps(indexes, index_step);
+	}
+
+	__m128 half_peaks = _mm_max_ps(_mm256_castps256_ps128(peaks), _mm256_extractf128_ps(peaks, 1));
+	half_peaks = _mm_max_ps(half_peaks, _mm_movehl_ps(half_peaks, half_peaks));
+	half_peaks = _mm_max_ss(half_peaks, _mm_shuffle_ps(half_peaks, half_peaks, 1));
+	float peak = _mm_cvtss_f32(half_peaks);
+
+	float tail_peak = gp_gain_apply_scalar(source + i * 2, destination + i * 2, frames - i,
+			gain + gain_step * (float)i, gain_step);
+
+	return tail_peak > peak ? tail_peak : peak;
+}
+
+static bool has_avx2(void) {
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 1);
+	bool has_avx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0;
+	if (!has_avx || (_xgetbv(0) & 6) != 6) return false;
+
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+#ifdef GP_GAIN_NEON
+static float apply_neon(const float* source, float* destination, size_t frames, float gain, float gain_step) {
+	static const float initial_indexes[] = {0, 0, 1, 1};
+	float32x4_t gains = vdupq_n_f32(gain);
+	float32x4_t indexes = vld1q_f32(initial_indexes);
+	float32x4_t index_step = vdupq_n_f32(2);
+	float32x4_t peaks = vdupq_n_f32(0);
+
+	size_t i = 0;
+	for (; i + 2 <= frames; i += 2) {
+		float32x4_t samples = vmulq_f32(vld1q_f32(source + i * 2), vmlaq_n_f32(gains, indexes, gain_step));
+		vst1q_f32(destination + i * 2, samples);
+		peaks = vmaxq_f32(peaks, vabsq_f32(samples));
+		indexes = vaddq_f32(indexes, index_step);
+	}
+
+	float peak = vmaxvq_f32(peaks);
+
+	float tail_peak = gp_gain_apply_scalar(source + i * 2, destination + i * 2, frames - i,
+			gain + gain_step * (float)i, gain_step);
+
+	return tail_peak > peak ? tail_peak : peak;
+}
+#endif
+
+GpGainKernel gp_gain_select_kernel(const char** name) {
+	const char* kernel_name = "scalar";
+	GpGainKernel kernel = gp_gain_apply_scalar;
+
+#if defined(GP_GAIN_X86)
+	kernel_name = "sse2";
+	kernel = apply_sse2;
+	if (has_avx2()) {
+		kernel_name = "avx2";
+		kernel = apply_avx2;
+	}
+#elif defined(GP_GAIN_NEON)
+	kernel_name = "neon";
+	kernel = apply_neon;
+#endif
+
+	if (name != NULL) *name = kernel_name;
+	return kernel;
+}
+
+void gp_gain_stage_init(struct GpGainStage* stage, uint32_t sample_rate) {
+	stage->volume = 1;
+	stage->source_gain = 1;
+	stage->kernel = gp_gain_select_kernel(NULL);
+	stage->gain = 1;
+	stage->gain_step = 0;
+	stage->next_gain = 1;
+	stage->limiter_gain = 1;
+	stage->chunk_frames = 0;
+	gp_gain_stage_set_sample_rate(stage, sample_rate);
+}
+
+void gp_gain_stage_set_sample_rate(struct GpGainStage* stage, uint32_t sample_rate) {
+	stage->max_gain_step = (float)(1 / (GP_GAIN_RAMP_SECONDS * sample_rate));
+	stage->limiter_release = (float)(1 / (GP_LIMITER_RELEASE_SECONDS * sample_rate));
+}
+
+void gp_gain_stage_set_volume(struct GpGainStage* stage, float volume) {
+	atomic_store_explicit(&stage->volume, volume > 0 ? volume : 0, memory_order_relaxed);
+}
+
+void gp_gain_stage_set_source_gain(struct GpGainStage* stage, float source_gain) {
+	atomic_store_explicit(&stage->source_gain, source_gain, memory_order_relaxed);
+}
+
+static float min_float(float a, float b) {
+	return a < b ? a : b;
+}
+
+static void apply_limiter(struct GpGainStage* stage, float* buffer, size_t frames, float peak) {
+	float limit = peak > GP_LIMITER_CEILING ? GP_LIMITER_CEILING / peak * (1 - 4 * FLT_EPSILON) : 1;
+	float limiter_gain = stage->limiter_gain;
+	float next_limiter_gain = limit;
+
+	if (limit < limiter_gain) {
+		limiter_gain = limit;
+	} else {
+		next_limiter_gain = min_float(limit, limiter_gain + stage->limiter_release * (float)frames);
+	}
+
+	if (limiter_gain < 1 || next_limiter_gain < 1) {
+		stage->kernel(buffer, buffer, frames, limiter_gain, (next_limiter_gain - limiter_gain) / (float)frames);
+	}
+	stage->limiter_gain = next_limiter_gain;
+}
+
+static void finish_chunk(struct GpGainStage* stage) {
+	float gain = stage->next_gain;
+	float target_gain = atomic_load_explicit(&stage->volume, memory_order_relaxed)
+			* atomic_load_explicit(&stage->source_gain, memory_order_relaxed);
+	float max_gain_change = stage->max_gain_step * GP_GAIN_CHUNK_FRAMES;
+	float next_gain = target_gain;
+	if (next_gain > gain + max_gain_change) next_gain = gain + max_gain_change;
+	if (next_gain < gain - max_gain_change) next_gain = gain - max_gain_change;
+
+	stage->gain = gain;
+	stage->gain_step = (next_gain - gain) / GP_GAIN_CHUNK_FRAMES;
+	stage->next_gain = next_gain;
+
+	stage->chunk_frames = 0;
+}
+
+void gp_gain_stage_process(struct GpGainStage* stage, float* buffer, size_t frames) {
+	while (frames > 0) {
+		size_t size = GP_GAIN_CHUNK_FRAMES - stage->chunk_frames;
+		if (size > frames) size = frames;
+
+		float offset_frames = (float)stage->chunk_frames;
+		float peak = stage->kernel(buffer, buffer, size, stage->gain + stage->gain_step * offset_frames,
+				stage->gain_step);
+		apply_limiter(stage, buffer, size, peak);
+
+		stage->chunk_frames += size;
+		buffer += size * GP_GAIN_CHANNELS;
+		frames -= size;
+
+		if (stage->chunk_frames == GP_GAIN_CHUNK_FRAMES) finish_chunk(stage);
+	}
+}
+
+static bool has_key(const char* tag, const char* key) {
+	size_t i = 0;
+	for (; key[i] != '\0'; i++) {
+		char character = tag[i];
+		if (character >= 'a' && character <= 'z') character = (char)(character - 'a' + 'A');
+		if (character != key[i]) return false;
+	}
+
+	return tag[i] == '=';
+}
+
+static bool find_gain(const char* tags, const char* key, double* gain) {
+	if (tags == NULL) return false;
+
+	for (const char* tag = tags; *tag != '\0'; tag += strlen(tag) + 1) {
+		if (!has_key(tag, key)) continue;
+
+		char* end;
+		*gain = strtod(tag + strlen(key) + 1, &end);
+		return end != tag + strlen(key) + 1;
+	}
+
+	return false;
+}
+
+float gp_gain_read_replay_gain(uint32_t stream_handle, enum GpReplayGainMode replay_gain_mode) {
+	if (replay_gain_mode == GP_REPLAY_GAIN_MODE_OFF || stream_handle == 0) return 1;
+
+	const char* key = replay_gain_mode == GP_REPLAY_GAIN_MODE_ALBUM
+			? "REPLAYGAIN_ALBUM_GAIN" : "REPLAYGAIN_TRACK_GAIN";
+
+	double gain;
+	if (!find_gain(BASS_ChannelGetTags(stream_handle, BASS_TAG_OGG), key, &gain)
+			&& !find_gain(BASS_ChannelGetTags(stream_handle, BASS_TAG_APE), key, &gain)) {
+		return 1;
+	}
+
+	return (float)pow(10, gain / 20);
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "grass_player.h"
+
+#define GP_GAIN_CHANNELS 2
+#define GP_GAIN_CHUNK_FRAMES 64
+#define GP_GAIN_RAMP_SECONDS 0.02
+#define GP_LIMITER_CEILING 0.8912509f
+#define GP_LIMITER_RELEASE_SECONDS 0.1
+
+typedef float (* GpGainKernel)(const float* source, float* destination, size_t frames, float gain, float gain_step);
+
+struct GpGainStage {
+  _Atomic float volume;
+  _Atomic float source_gain;
+  GpGainKernel kernel;
+  float gain;
+  float gain_step;
+  float next_gain;
+  float max_gain_step;
+  float limiter_gain;
+  float limiter_release;
+  size_t chunk_frames;
+};
+
+void gp_gain_stage_init(struct GpGainStage* stage, uint32_t sample_rate);
+void gp_gain_stage_set_sample_rate(struct GpGainStage* stage, uint32_t sample_rate);
+void gp_gain_stage_set_volume(struct GpGainStage* stage, float volume);
+void gp_gain_stage_set_source_gain(struct GpGainStage* stage, float source_gain);
+void gp_gain_stage_process(struct GpGainStage* stage, float* buffer, size_t frames);
+float gp_gain_read_replay_gain(uint32_t stream_handle, enum GpReplayGainMode replay_gain_mode);
+
+GpGainKernel gp_gain_select_kernel(const char** name);
+float gp_gain_apply_scalar(const float* source, float* destination, size_t frames, float gain, float gain_step);
@@ -0,0 +1,477 @@
+#include "gp_loudness.h"
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bass.h"
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__)
+#define GP_LOUDNESS_SSE2
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define GP_LOUDNESS_NEON
+#include <arm_neon.h>
+#endif
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+struct GpSegments {
+  double* energies;
+  size_t size;
+  size_t capacity;
+};
+
+void gp_k_weighting_init(struct GpKWeighting* weighting, double sample_rate) {
+	double k = tan(M_PI * 1681.974450955533 / sample_rate);
+	double q = 0.7071752369554196;
+	double high_gain = pow(10, 3.999843853973347 / 20);
+	double band_gain = pow(high_gain, 0.4996667741545416);
+	double a0 = 1 + k / q + k * k;
+
+	weighting->b0[0] = (high_gain + band_gain * k / q + k * k) / a0;
+	weighting->b1[0] = 2 * (k * k - high_gain) / a0;
+	weighting->b2[0] = (high_gain - band_gain * k / q + k * k) / a0;
+	weighting->a1[0] = 2 * (k * k - 1) / a0;
+	weighting->a2[0] = (1 - k / q + k * k) / a0;
+
+	k = tan(M_PI * 38.13547087602444 / sample_rate);
+	q = 0.5003270373238773;
+	a0 = 1 + k / q + k * k;
+
+	weighting->b0[1] = 1;
+	weighting->b1[1] = -2;
+	weighting->b2[1] = 1;
+	weighting->a1[1] = 2 * (k * k - 1) / a0;
+	weighting->a2[1] = (1 - k / q + k * k) / a0;
+}
+
+void gp_true_peak_init(float* coefficients) {
+	size_t taps_size = GP_TRUE_PEAK_TAPS * GP_TRUE_PEAK_PHASES;
+	double center = (double)(taps_size - 1) / 2;
+	double taps[GP_TRUE_PEAK_TAPS * GP_TRUE_PEAK_PHASES];
+
+	for (size_t i = 0; i < taps_size; i++) {
+		double t = ((double)i - center) / GP_TRUE_PEAK_PHASES;
+		double window = 0.5 - 0.5 * cos(2 * M_PI * ((double)i + 0.5) / (double)taps_size);
+		taps[i] = t == 0 ? window : sin(M_PI * t) / (M_PI * t) * window;
+	}
+
+	for (size_t phase = 0; phase < GP_TRUE_PEAK_PHASES; phase++) {
+		double sum = 0;
+		for (size_t tap = 0; tap < GP_TRUE_PEAK_TAPS; tap++) sum += taps[tap * GP_TRUE_PEAK_PHASES + phase];
+
+		for (size_t tap = 0; tap < GP_TRUE_PEAK_TAPS; tap++) {
+			coefficients[tap * GP_TRUE_PEAK_PHASES + phase] = (float)(taps[tap * GP_TRUE_PEAK_PHASES + phase] / sum);
+		}
+	}
+}
+
+static double filter_channel(const struct GpKWeighting* weighting, double* state, const float* samples,
+		size_t stride, size_t frames) {
+	double s0 = state[0];
+	double s1 = state[1];
+	double s2 = state[2];
+	double s3 = state[3];
+	double energy = 0;
+
+	for (size_t i = 0; i < frames; i++) {
+		double x = samples[i * stride];
+		double y = weighting->b0[0] * x + s0;
+		s0 = weighting->b1[0] * x - weighting->a1[0] * y + s1;
+		s1 = weighting->b2[0] * x - weighting->a2[0] * y;
+		double z = weighting->b0[1] * y + s2;
+		s2 = weighting->b1[1] * y - weighting->a1[1] * z + s3;
+		s3 = weighting->b2[1] * y - weighting->a2[1] * z;
+		energy += z * z;
+	}
+
+	state[0] = s0;
+	state[1] = s1;
+	state[2] = s2;
+	state[3] = s3;
+
+	return energy;
+}
+
+void gp_k_weighting_scalar(const struct GpKWeighting* weighting, double* states, const float* samples,
+		size_t frames, size_t channels, double* energies) {
+	for (size_t channel = 0; channel < channels; channel++) {
+		energies[channel] += filter_channel(weighting, states + channel * 4, samples + channel, channels, frames);
+	}
+}
+
+float gp_true_peak_scalar(const float* samples, size_t frames, const float* coefficients) {
+	float peak = 0;
+
+	for (size_t i = 0; i < frames; i++) {
+		const float* x = samples + i + GP_TRUE_PEAK_TAPS - 1;
+		if (fabsf(x[0]) > peak) peak = fabsf(x[0]);
+
+		for (size_t phase = 0; phase < GP_TRUE_PEAK_PHASES; phase++) {
+			float sum = coefficients[phase] * x[0];
+			for (size_t tap = 1; tap < GP_TRUE_PEAK_TAPS; tap++) {
+				sum += coefficients[tap * GP_TRUE_PEAK_PHASES + phase] * x[-(ptrdiff_t)tap];
+			}
+			if (fabsf(sum) > peak) peak = fabsf(sum);
+		}
+	}
+
+	return peak;
+}
+
+#ifdef GP_LOUDNESS_SSE2
+static void k_weighting_sse2(const struct GpKWeighting* weighting, double* states, const float* samples,
+		size_t frames, size_t channels, double* energies) {
+	__m128d b00 = _mm_set1_pd(weighting->b0[0]);
+	__m128d b10 = _mm_set1_pd(weighting->b1[0]);
+	__m128d b20 = _mm_set1_pd(weighting->b2[0]);
+	__m128d a10 = _mm_set1_pd(weighting->a1[0]);
+	__m128d a20 = _mm_set1_pd(weighting->a2[0]);
+	__m128d b01 = _mm_set1_pd(weighting->b0[1]);
+	__m128d b11 = _mm_set1_pd(weighting->b1[1]);
+	__m128d b21 = _mm_set1_pd(weighting->b2[1]);
+	__m128d a11 = _mm_set1_pd(weighting->a1[1]);
+	__m128d a21 = _mm_set1_pd(weighting->a2[1]);
+
+	size_t channel = 0;
+	for (; channel + 2 <= channels; channel += 2) {
+		double* state = states + channel * 4;
+		__m128d s0 = _mm_setr_pd(state[0], state[4]);
+		__m128d s1 = _mm_setr_pd(state[1], state[5]);
+		__m128d s2 = _mm_setr_pd(state[2], state[6]);
+		__m128d s3 = _mm_setr_pd(state[3], state[7]);
+		__m128d energy = _mm_setzero_pd();
+
+		for (size_t i = 0; i < frames; i++) {
+			const float* frame = samples + i * channels + channel;
+			__m128d x = _mm_setr_pd(frame[0], frame[1]);
+			__m128d y = _mm_add_pd(_mm_mul_pd(b00, x), s0);
+			s0 = _mm_add_pd(_mm_sub_pd(_mm_mul_pd(b10, x), _mm_mul_pd(a10, y)), s1);
+			s1 = _mm_sub_pd(_mm_mul_pd(b20, x), _mm_mul_pd(a20, y));
+			__m128d z = _mm_add_pd(_mm_mul_pd(b01, y), s2);
+			s2 = _mm_add_pd(_mm_sub_pd(_mm_mul_pd(b11, y), _mm_mul_pd(a11, z)), s3);
+			s3 = _mm_sub_pd(_mm_mul_pd(b21, y), _mm_mul_pd(a21, z));
+			energy = _mm_add_pd(energy, _mm_mul_pd(z, z));
+		}
+
+		double lanes[2];
+		_mm_storel_pd(&state[0], s0);
+		_mm_storeh_pd(&state[4], s0);
+		_mm_storel_pd(&state[1], s1);
+		_mm_storeh_pd(&state[5], s1);
+		_mm_storel_pd(&state[2], s2);
+		_mm_storeh_pd(&state[6], s2);
+		_mm_storel_pd(&state[3], s3);
+		_mm_storeh_pd(&state[7], s3);
+		_mm_storeu_pd(lanes, energy);
+		energies[channel] += lanes[0];
+		energies[channel + 1] += lanes[1];
+	}
+
+	if (channel < channels) {
+		energies[channel] += filter_channel(weighting, states + channel * 4, samples + channel, channels, frames);
+	}
+}
+
+static float true_peak_sse2(const float* samples, size_t frames, const float* coefficients) {
+	__m128 taps[GP_TRUE_PEAK_TAPS];
+	for (size_t tap = 0; tap < GP_TRUE_PEAK_TAPS; tap++) {
+		taps[tap] = _mm_loadu_ps(coefficients + tap * GP_TRUE_PEAK_PHASES);
+	}
+
+	__m128 sign = _mm_set1_ps(-0.0f);
+	__m128 peaks = _mm_setzero_ps();
+
+	for (size_t i = 0; i < frames; i++) {
+		const float* x = samples + i + GP_TRUE_PEAK_TAPS - 1;
+		__m128 sample = _mm_set1_ps(x[0]);
+		__m128 sum = _mm_mul_ps(taps[0], sample);
+		for (size_t tap = 1; tap < GP_TRUE_PEAK_TAPS; tap++) {
+			sum = _mm_add_ps(sum, _mm_mul_ps(taps[tap], _mm_set1_ps(x[-(ptrdiff_t)tap])));
+		}
+		peaks = _mm_max_ps(peaks, _mm_max_ps(_mm_andnot_ps(sign, sum), _mm_andnot_ps(sign, sample)));
+	}
+
+	peaks = _mm_max_ps(peaks, _mm_movehl_ps(peaks, peaks));
+	peaks = _mm_max_ss(peaks, _mm_shuffle_ps(peaks, peaks, 1));
+	return _mm_cvtss_f32(peaks);
+}
+#endif
+
+#ifdef GP_LOUDNESS_NEON
+static void k_weighting_neon(const struct GpKWeighting* weighting, double* states, const float* samples,
+		size_t frames, size_t channels, double* energies) {
+	size_t channel = 0;
+	for (; channel + 2 <= channels; channel += 2) {
+		double* state = states + channel * 4;
+		double pair[2];
+		pair[0] = state[0];
+		pair[1] = state[4];
+		float64x2_t s0 = vld1q_f64(pair);
+		pair[0] = state[1];
+		pair[1] = state[5];
+		float64x2_t s1 = vld1q_f64(pair);
+		pair[0] = state[2];
+		pair[1] = state[6];
+		float64x2_t s2 = vld1q_f64(pair);
+		pair[0] = state[3];
+		pair[1] = state[7];
+		float64x2_t s3 = vld1q_f64(pair);
+		float64x2_t energy = vdupq_n_f64(0);
+
+		for (size_t i = 0; i < frames; i++) {
+			const float* frame = samples + i * channels + channel;
+			pair[0] = frame[0];
+			pair[1] = frame[1];
+			float64x2_t x = vld1q_f64(pair);
+			float64x2_t y = vaddq_f64(vmulq_n_f64(x, weighting->b0[0]), s0);
+			s0 = vaddq_f64(vsubq_f64(vmulq_n_f64(x, weighting->b1[0]), vmulq_n_f64(y, weighting->a1[0])), s1);
+			s1 = vsubq_f64(vmulq_n_f64(x, weighting->b2[0]), vmulq_n_f64(y, weighting->a2[0]));
+			float64x2_t z = vaddq_f64(vmulq_n_f64(y, weighting->b0[1]), s2);
+			s2 = vaddq_f64(vsubq_f64(vmulq_n_f64(y, weighting->b1[1]), vmulq_n_f64(z, weighting->a1[1])), s3);
+			s3 = vsubq_f64(vmulq_n_f64(y, weighting->b2[1]), vmulq_n_f64(z, weighting->a2[1]));
+			energy = vaddq_f64(energy, vmulq_f64(z, z));
+		}
+
+		state[0] = vgetq_lane_f64(s0, 0);
+		state[4] = vgetq_lane_f64(s0, 1);
+		state[1] = vgetq_lane_f64(s1, 0);
+		state[5] = vgetq_lane_f64(s1, 1);
+		state[2] = vgetq_lane_f64(s2, 0);
+		state[6] = vgetq_lane_f64(s2, 1);
+		state[3] = vgetq_lane_f64(s3, 0);
+		state[7] = vgetq_lane_f64(s3, 1);
+		energies[channel] += vgetq_lane_f64(energy, 0);
+		energies[channel + 1] += vgetq_lane_f64(energy, 1);
+	}
+
+	if (channel < channels) {
+		energies[channel] += filter_channel(weighting, states + channel * 4, samples + channel, channels, frames);
+	}
+}
+
+static float true_peak_neon(const float* samples, size_t frames, const float* coefficients) {
+	float32x4_t taps[GP_TRUE_PEAK_TAPS];
+	for (size_t tap = 0; tap < GP_TRUE_PEAK_TAPS; tap++) {
+		taps[tap] = vld1q_f32(coefficients + tap * GP_TRUE_PEAK_PHASES);
+	}
+
+	float32x4_t peaks = vdupq_n_f32(0);
+
+	for (size_t i = 0; i < frames; i++) {
+		const float* x = samples + i + GP_TRUE_PEAK_TAPS - 1;
+		float32x4_t sum = vmulq_n_f32(taps[0], x[0]);
+		for (size_t tap = 1; tap < GP_TRUE_PEAK_TAPS; tap++) {
+			sum = vaddq_f32(sum, vmulq_n_f32(taps[tap], x[-(ptrdiff_t)tap]));
+		}
+		peaks = vmaxq_f32(peaks, vmaxq_f32(vabsq_f32(sum), vdupq_n_f32(fabsf(x[0]))));
+	}
+
+	return vmaxvq_f32(peaks);
+}
+#endif
+
+void gp_loudness_select_kernels(GpKWeightingKernel* k_weighting, GpTruePeakKernel* true_peak, const char** name) {
+#if defined(GP_LOUDNESS_SSE2)
+	*k_weighting = k_weighting_sse2;
+	*true_peak = true_peak_sse2;
+	if (name != NULL) *name = "sse2";
+#elif defined(GP_LOUDNESS_NEON)
+	*k_weighting = k_weighting_neon;
+	*true_peak = true_peak_neon;
+	if (name != NULL) *name = "neon";
+#else
+	*k_weighting = gp_k_weighting_scalar;
+	*true_peak = gp_true_peak_scalar;
+	if (name != NULL) *name = "scalar";
+#endif
+}
+
+static double channel_weight(size_t channel, size_t channels) {
+	if (channels == 6) return channel == 3 ? 0 : channel >= 4 ? 1.41 : 1;
+	if (channels == 5) return channel >= 3 ? 1.41 : 1;
+	return 1;
+}
+
+static double energy_to_loudness(double energy) {
+	return -0.691 + 10 * log10(energy);
+}
+
+static enum GpResult push_segment(struct GpSegments* segments, double energy) {
+	if (segments->size == segments->capacity) {
+		size_t capacity = segments->capacity > 0 ? segments->capacity * 2 : 1024;
+		double* energies = realloc(segments->energies, capacity * sizeof(double));
+		if (energies == NULL) return GP_RESULT_ERROR;
+
+		segments->energies = energies;
+		segments->capacity = capacity;
+	}
+
+	segments->energies[segments->size++] = energy;
+	return GP_RESULT_OK;
+}
+
+static size_t window_energies(const struct GpSegments* segments, size_t window_size, double* energies) {
+	if (segments->size < window_size) return 0;
+
+	size_t windows_size = segments->size - window_size + 1;
+	for (size_t i = 0; i < windows_size; i++) {
+		double sum = 0;
+		for (size_t j = 0; j < window_size; j++) sum += segments->energies[i + j];
+		energies[i] = sum / (double)window_size;
+	}
+
+	return windows_size;
+}
+
+static double gated_mean(const double* energies, size_t energies_size, double threshold) {
+	double sum = 0;
+	size_t size = 0;
+	for (size_t i = 0; i < energies_size; i++) {
+		if (energy_to_loudness(energies[i]) <= threshold) continue;
+		sum += energies[i];
+		size++;
+	}
+
+	return size > 0 ? sum / (double)size : 0;
+}
+
+static int compare_doubles(const void* a, const void* b) {
+	double x = *(const double*)a;
+	double y = *(const double*)b;
+	return (x > y) - (x < y);
+}
+
+static double integrated_loudness(const struct GpSegments* segments, double* energies) {
+	size_t energies_size = window_energies(segments, GP_LOUDNESS_GATING_SEGMENTS, energies);
+	double mean = gated_mean(energies, energies_size, GP_LOUDNESS_ABSOLUTE_GATE);
+	if (mean == 0) return -HUGE_VAL;
+
+	return energy_to_loudness(gated_mean(energies, energies_size,
+			energy_to_loudness(mean) + GP_LOUDNESS_RELATIVE_GATE));
+}
+
+static double loudness_range(const struct GpSegments* segments, double* energies) {
+	size_t energies_size = window_energies(segments, GP_LOUDNESS_SHORT_TERM_SEGMENTS, energies);
+	double mean = gated_mean(energies, energies_size, GP_LOUDNESS_ABSOLUTE_GATE);
+	if (mean == 0) return 0;
+
+	double threshold = energy_to_loudness(mean) + GP_LOUDNESS_RANGE_GATE;
+	size_t gated_size = 0;
+	for (size_t i = 0; i < energies_size; i++) {
+		double loudness = energy_to_loudness(energies[i]);
+		if (loudness > GP_LOUDNESS_ABSOLUTE_GATE && loudness > threshold) energies[gated_size++] = loudness;
+	}
+	if (gated_size < 2) return 0;
+
+	qsort(energies, gated_size, sizeof(double), compare_doubles);
+	size_t low = (size_t)(0.10 * (double)(gated_size - 1) + 0.5);
+	size_t high = (size_t)(0.95 * (double)(gated_size - 1) + 0.5);
+
+	return energies[high] - energies[low];
+}
+
+static enum GpResult measure(uint32_t stream_handle, size_t channels, uint32_t sample_rate,
+		struct GpSegments* segments, float* peak) {
+	struct GpKWeighting weighting;
+	gp_k_weighting_init(&weighting, sample_rate);
+	float coefficients[GP_TRUE_PEAK_TAPS * GP_TRUE_PEAK_PHASES];
+	gp_true_peak_init(coefficients);
+
+	GpKWeightingKernel k_weighting;
+	GpTruePeakKernel true_peak;
+	gp_loudness_select_kernels(&k_weighting, &true_peak, NULL);
+
+	size_t history_size = GP_TRUE_PEAK_TAPS - 1;
+	float* buffer = malloc(GP_LOUDNESS_BLOCK_FRAMES * channels * sizeof(float));
+	float* channel_buffer = calloc(history_size + GP_LOUDNESS_BLOCK_FRAMES, sizeof(float));
+	float* history = calloc(history_size * channels, sizeof(float));
+	if (buffer == NULL || channel_buffer == NULL || history == NULL) {
+		free(buffer);
+		free(channel_buffer);
+		free(history);
+		return GP_RESULT_ERROR;
+	}
+
+	double states[GP_LOUDNESS_MAX_CHANNELS * 4] = {0};
+	double energies[GP_LOUDNESS_MAX_CHANNELS] = {0};
+	size_t segment_frames = (size_t)(sample_rate * GP_LOUDNESS_SEGMENT_SECONDS + 0.5);
+	size_t segment_position = 0;
+	enum GpResult result = GP_RESULT_OK;
+	*peak = 0;
+
+	while (result == GP_RESULT_OK) {
+		uint32_t read_bytes = BASS_ChannelGetData(stream_handle, buffer,
+				(uint32_t)(GP_LOUDNESS_BLOCK_FRAMES * channels * sizeof(float)));
+		if (read_bytes == (uint32_t)-1 || read_bytes == 0) break;
+
+		size_t frames = read_bytes / (channels * sizeof(float));
+
+		for (size_t channel = 0; channel < channels; channel++) {
+			memcpy(channel_buffer, history + channel * history_size, history_size * sizeof(float));
+			for (size_t i = 0; i < frames; i++) channel_buffer[history_size + i] = buffer[i * channels + channel];
+			memcpy(history + channel * history_size, channel_buffer + frames, history_size * sizeof(float));
+
+			float channel_peak = true_peak(channel_buffer, frames, coefficients);
+			if (channel_peak > *peak) *peak = channel_peak;
+		}
+
+		for (size_t offset = 0; offset < frames;) {
+			size_t size = segment_frames - segment_position;
+			if (size > frames - offset) size = frames - offset;
+
+			k_weighting(&weighting, states, buffer + offset * channels, size, channels, energies);
+			segment_position += size;
+			offset += size;
+
+			if (segment_position < segment_frames) continue;
+
+			double energy = 0;
+			for (size_t channel = 0; channel < channels; channel++) {
+				energy += channel_weight(channel, channels) * energies[channel] / (double)segment_frames;
+				energies[channel] = 0;
+			}
+			segment_position = 0;
+			result = push_segment(segments, energy);
+		}
+	}
+
+	free(buffer);
+	free(channel_buffer);
+	free(history);
+
+	return result;
+}
+
+enum GpResult gp_loudness_analyze(const struct GpSource* source, struct GpLoudnessInfo* loudness) {
+	uint32_t stream_handle = gp_source_create_stream(source, BASS_STREAM_DECODE | BASS_SAMPLE_FLOAT);
+	if (stream_handle == 0) return GP_RESULT_ERROR;
+
+	BASS_CHANNELINFO channel_info;
+	if (!BASS_ChannelGetInfo(stream_handle, &channel_info) || channel_info.chans == 0
+			|| channel_info.chans > GP_LOUDNESS_MAX_CHANNELS || channel_info.freq == 0) {
+		BASS_StreamFree(stream_handle);
+		return GP_RESULT_ERROR;
+	}
+
+	struct GpSegments segments = {0};
+	float peak;
+	enum GpResult result = measure(stream_handle, channel_info.chans, channel_info.freq, &segments, &peak);
+	BASS_StreamFree(stream_handle);
+
+	double* energies = result == GP_RESULT_OK ? malloc((segments.size + 1) * sizeof(double)) : NULL;
+	if (energies == NULL) {
+		free(segments.energies);
+		return GP_RESULT_ERROR;
+	}
+
+	loudness->integrated_loudness = integrated_loudness(&segments, energies);
+	loudness->loudness_range = loudness_range(&segments, energies);
+	loudness->true_peak = 20 * log10(peak);
+
+	free(energies);
+	free(segments.energies);
+
+	return GP_RESULT_OK;
+}
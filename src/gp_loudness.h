@@ -0,0 +1,36 @@
+#pragma once
+#include <stddef.h>
+#include "grass_player.h"
+#include "gp_source.h"
+
+#define GP_LOUDNESS_MAX_CHANNELS 8
+#define GP_LOUDNESS_BLOCK_FRAMES 4096
+#define GP_LOUDNESS_SEGMENT_SECONDS 0.1
+#define GP_LOUDNESS_GATING_SEGMENTS 4
+#define GP_LOUDNESS_SHORT_TERM_SEGMENTS 30
+#define GP_LOUDNESS_ABSOLUTE_GATE (-70.0)
+#define GP_LOUDNESS_RELATIVE_GATE (-10.0)
+#define GP_LOUDNESS_RANGE_GATE (-20.0)
+#define GP_TRUE_PEAK_PHASES 4
+#define GP_TRUE_PEAK_TAPS 12
+
+struct GpKWeighting {
+  double b0[2];
+  double b1[2];
+  double b2[2];
+  double a1[2];
+  double a2[2];
+};
+
+typedef void (* GpKWeightingKernel)(const struct GpKWeighting* weighting, double* states, const float* samples,
+		size_t frames, size_t channels, double* energies);
+typedef float (* GpTruePeakKernel)(const float* samples, size_t frames, const float* coefficients);
+
+void gp_k_weighting_init(struct GpKWeighting* weighting, double sample_rate);
+void gp_true_peak_init(float* coefficients);
+void gp_loudness_select_kernels(GpKWeightingKernel* k_weighting, GpTruePeakKernel* true_peak, const char** name);
+void gp_k_weighting_scalar(const struct GpKWeighting* weighting, double* states, const float* samples,
+		size_t frames, size_t channels, double* energies);
+float gp_true_peak_scalar(const float* samples, size_t frames, const float* coefficients);
+
+enum GpResult gp_loudness_analyze(const struct GpSource* source, struct GpLoudnessInfo* loudness);
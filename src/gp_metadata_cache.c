@@ -0,0 +1,593 @@
+#include "gp_metadata_cache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "bass.h"
+#include "bassflac.h"
+#include "gp_loudness.h"
+#include "gp_source.h"
+
+static uint64_t hash_path(const char* path, size_t path_size) {
+	uint64_t hash = 14695981039346656037ULL;
+	for (size_t i = 0; i < path_size; i++) {
+		hash ^= (uint8_t)path[i];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+static enum GpResult reserve(void** buffer, size_t* capacity, size_t required, size_t element_size) {
+	if (*buffer != NULL && required <= *capacity) return GP_RESULT_OK;
+
+	size_t new_capacity = *capacity * 2;
+	if (new_capacity < required) new_capacity = required;
+	if (new_capacity == 0) new_capacity = 1;
+
+	void* new_buffer = realloc(*buffer, new_capacity * element_size);
+	if (new_buffer == NULL) return GP_RESULT_ERROR;
+
+	*buffer = new_buffer;
+	*capacity = new_capacity;
+	return GP_RESULT_OK;
+}
+
+static struct GpMetadataRecord* table_find(const struct GpMetadataTable* table, uint64_t hash,
+		const char* path, size_t path_size) {
+	if (table->buckets_size == 0) return NULL;
+
+	size_t mask = table->buckets_size - 1;
+	for (size_t i = hash & mask;; i = (i + 1) & mask) {
+		uint32_t bucket = table->buckets[i];
+		if (bucket == 0) return NULL;
+
+		struct GpMetadataRecord* record = &table->records[bucket - 1];
+		if (record->hash == hash && record->path_size == path_size
+				&& memcmp(table->pool + record->path_offset, path, path_size) == 0) {
+			return record;
+		}
+	}
+}
+
+static void table_link(struct GpMetadataTable* table, size_t record_index) {
+	size_t mask = table->buckets_size - 1;
+	size_t i = table->records[record_index].hash & mask;
+	while (table->buckets[i] != 0) i = (i + 1) & mask;
+	table->buckets[i] = (uint32_t)(record_index + 1);
+}
+
+static enum GpResult table_rehash(struct GpMetadataTable* table, size_t buckets_size) {
+	uint32_t* buckets = calloc(buckets_size, sizeof(uint32_t));
+	if (buckets == NULL) return GP_RESULT_ERROR;
+
+	free(table->buckets);
+	table->buckets = buckets;
+	table->buckets_size = buckets_size;
+
+	for (size_t i = 0; i < table->records_size; i++) table_link(table, i);
+
+	return GP_RESULT_OK;
+}
+
+static size_t record_pool_size(const struct GpMetadataRecord* record) {
+	return record->path_size + (size_t)record->seek_points_size * GP_SEEK_POINT_SIZE;
+}
+
+static enum GpResult table_append_pool(struct GpMetadataTable* table, const struct GpMetadataRecord* record,
+		const char* path, const uint8_t* seek_points, uint64_t* path_offset) {
+	if (reserve((void**)&table->pool, &table->pool_capacity, table->pool_size + record_pool_size(record), 1)
+			!= GP_RESULT_OK) {
+		return GP_RESULT_ERROR;
+	}
+
+	memcpy(table->pool + table->pool_size, path, record->path_size);
+	if (record->seek_points_size > 0) {
+		memcpy(table->pool + table->pool_size + record->path_size, seek_points,
+				(size_t)record->seek_points_size * GP_SEEK_POINT_SIZE);
+	}
+
+	*path_offset = table->pool_size;
+	table->pool_size += record_pool_size(record);
+
+	return GP_RESULT_OK;
+}
+
+static enum GpResult table_insert(struct GpMetadataTable* table, const struct GpMetadataRecord* record,
+		const char* path, const uint8_t* seek_points) {
+	struct GpMetadataRecord* existing = table_find(table, record->hash, path, record->path_size);
+	if (existing != NULL) {
+		uint64_t path_offset = existing->path_offset;
+		if (record->seek_points_size > 0
+				&& table_append_pool(table, record, path, seek_points, &path_offset) != GP_RESULT_OK) {
+			return GP_RESULT_ERROR;
+		}
+
+		*existing = *record;
+		existing->path_offset = path_offset;
+		return GP_RESULT_OK;
+	}
+
+	if ((table->records_size + 1) * 2 > table->buckets_size) {
+		size_t buckets_size = table->buckets_size > 0 ? table->buckets_size * 2 : 16;
+		if (table_rehash(table, buckets_size) != GP_RESULT_OK) return GP_RESULT_ERROR;
+	}
+
+	uint64_t path_offset;
+	if (reserve((void**)&table->records, &table->records_capacity, table->records_size + 1,
+			sizeof(struct GpMetadataRecord)) != GP_RESULT_OK
+			|| table_append_pool(table, record, path, seek_points, &path_offset) != GP_RESULT_OK) {
+		return GP_RESULT_ERROR;
+	}
+
+	struct GpMetadataRecord* new_record = &table->records[table->records_size];
+	*new_record = *record;
+	new_record->path_offset = path_offset;
+
+	table_link(table, table->records_size++);
+
+	return GP_RESULT_OK;
+}
+
+static void table_free(struct GpMetadataTable* table) {
+	free(table->records);
+	free(table->buckets);
+	free(table->pool);
+	*table = (struct GpMetadataTable){0};
+}
+
+static void close_file_map(struct GpMetadataCache* cache) {
+	if (cache->file_map != NULL) gp_file_map_close(cache->file_map);
+	cache->file_map = NULL;
+	cache->mapped = (struct GpMetadataTable){0};
+}
+
+static enum GpResult open_file_map(struct GpMetadataCache* cache) {
+	struct GpSource* source = gp_new_source(cache->path);
+	if (source == NULL) return GP_RESULT_ERROR;
+
+	struct GpFileMap* file_map = gp_file_map_open(source, GP_FILE_MAP_ACCESS_RANDOM);
+	gp_free_source(source);
+	if (file_map == NULL) return GP_RESULT_OK;
+
+	const struct GpMetadataCacheHeader* header = (const struct GpMetadataCacheHeader*)file_map->data;
+	uint64_t available_size = file_map->size - sizeof(struct GpMetadataCacheHeader);
+
+	if (file_map->size < sizeof(struct GpMetadataCacheHeader)
+			|| header->magic != GP_METADATA_CACHE_MAGIC
+			|| header->version != GP_METADATA_CACHE_VERSION
+			|| header->buckets_size == 0
+			|| (header->buckets_size & (header->buckets_size - 1)) != 0
+			|| header->records_size >= header->buckets_size
+			|| header->records_size > available_size / sizeof(struct GpMetadataRecord)
+			|| header->buckets_size > (available_size - header->records_size * sizeof(struct GpMetadataRecord))
+					/ sizeof(uint32_t)
+			|| header->pool_size != available_size - header->records_size * sizeof(struct GpMetadataRecord)
+					- header->buckets_size * sizeof(uint32_t)) {
+		gp_file_map_close(file_map);
+		return GP_RESULT_OK;
+	}
+
+	struct GpMetadataTable mapped = {0};
+	mapped.records = (struct GpMetadataRecord*)(file_map->data + sizeof(struct GpMetadataCacheHeader));
+	mapped.records_size = header->records_size;
+	mapped.buckets = (uint32_t*)(mapped.records + mapped.records_size);
+	mapped.buckets_size = header->buckets_size;
+	mapped.pool = (char*)(mapped.buckets + mapped.buckets_size);
+	mapped.pool_size = header->pool_size;
+
+	for (size_t i = 0; i < mapped.records_size; i++) {
+		const struct GpMetadataRecord* record = &mapped.records[i];
+		if (record->path_offset > mapped.pool_size || record_pool_size(record) > mapped.pool_size - record->path_offset) {
+			gp_file_map_close(file_map);
+			return GP_RESULT_OK;
+		}
+	}
+	for (size_t i = 0; i < mapped.buckets_size; i++) {
+		if (mapped.buckets[i] > mapped.records_size) {
+			gp_file_map_close(file_map);
+			return GP_RESULT_OK;
+		}
+	}
+
+	cache->file_map = file_map;
+	cache->mapped = mapped;
+
+	return GP_RESULT_OK;
+}
+
+static enum GpResult write_table(const struct GpMetadataTable* table, const char* path) {
+	FILE* file = fopen(path, "wb");
+	if (file == NULL) return GP_RESULT_ERROR;
+
+	struct GpMetadataCacheHeader header = {
+			GP_METADATA_CACHE_MAGIC,
+			GP_METADATA_CACHE_VERSION,
+			table->records_size,
+			table->buckets_size,
+			table->pool_size
+	};
+
+	bool written = fwrite(&header, sizeof(header), 1, file) == 1
+			&& fwrite(table->records, sizeof(struct GpMetadataRecord), table->records_size, file) == table->records_size
+			&& fwrite(table->buckets, sizeof(uint32_t), table->buckets_size, file) == table->buckets_size
+			&& fwrite(table->pool, 1, table->pool_size, file) == table->pool_size;
+
+	if (fclose(file) != 0 || !written) {
+		remove(path);
+		return GP_RESULT_ERROR;
+	}
+
+	return GP_RESULT_OK;
+}
+
+static enum GpCodec get_codec(uint32_t channel_type) {
+	switch (channel_type) {
+	case BASS_CTYPE_STREAM_FLAC:
+	case BASS_CTYPE_STREAM_FLAC_OGG: return GP_CODEC_FLAC;
+	case BASS_CTYPE_STREAM_OGG: return GP_CODEC_OGG;
+	case BASS_CTYPE_STREAM_MP1:
+	case BASS_CTYPE_STREAM_MP2:
+	case BASS_CTYPE_STREAM_MP3: return GP_CODEC_MP3;
+	case BASS_CTYPE_STREAM_AIFF: return GP_CODEC_AIFF;
+	default: return (channel_type & BASS_CTYPE_STREAM_WAV) != 0 ? GP_CODEC_WAV : GP_CODEC_UNKNOWN;
+	}
+}
+
+static enum GpResult probe_source(const struct GpSource* source, struct GpMetadataRecord* record) {
+	uint32_t stream_handle = gp_source_create_stream(source, BASS_STREAM_DECODE);
+	if (stream_handle == 0) return GP_RESULT_ERROR;
+
+	BASS_CHANNELINFO channel_info;
+	if (!BASS_ChannelGetInfo(stream_handle, &channel_info)) {
+		BASS_StreamFree(stream_handle);
+		return GP_RESULT_ERROR;
+	}
+
+	record->duration = BASS_ChannelBytes2Seconds(stream_handle,
+			BASS_ChannelGetLength(stream_handle, BASS_POS_BYTE));
+	record->sample_rate = channel_info.freq;
+	record->channels = (uint16_t)channel_info.chans;
+	record->bits_per_sample = (uint16_t)(channel_info.origres & 0xffff);
+	record->codec = get_codec(channel_info.ctype);
+
+	BASS_StreamFree(stream_handle);
+	return GP_RESULT_OK;
+}
+
+static enum GpResult get_file_key(const struct GpSource* source, uint64_t* file_size, int64_t* file_time) {
+#ifdef _WIN32
+	struct _stat64 file_stat;
+	const wchar_t* native_path = gp_source_native_path(source);
+	if (native_path == NULL) return GP_RESULT_ERROR;
+
+	int stat_result = _wstat64(native_path, &file_stat);
+	gp_source_free_native_path(source, native_path);
+	if (stat_result != 0) return GP_RESULT_ERROR;
+#else
+	struct stat file_stat;
+	if (stat(source->path, &file_stat) != 0) return GP_RESULT_ERROR;
+#endif
+
+	*file_size = (uint64_t)file_stat.st_size;
+	*file_time = (int64_t)file_stat.st_mtime;
+	return GP_RESULT_OK;
+}
+
+static void copy_info(const struct GpMetadataRecord* record, struct GpSourceInfo* info) {
+	info->duration = record->duration;
+	info->sample_rate = record->sample_rate;
+	info->channels = record->channels;
+	info->bits_per_sample = record->bits_per_sample;
+	info->codec = (enum GpCodec)record->codec;
+}
+
+struct GpMetadataCache* gp_new_metadata_cache(void) {
+	struct GpMetadataCache* cache = calloc(1, sizeof(struct GpMetadataCache));
+	if (cache == NULL) return NULL;
+
+	if (mtx_init(&cache->mutex, mtx_plain) != thrd_success) {
+		free(cache);
+		return NULL;
+	}
+
+	return cache;
+}
+
+void gp_free_metadata_cache(struct GpMetadataCache* cache) {
+	if (cache == NULL) return;
+
+	close_file_map(cache);
+	table_free(&cache->added);
+	mtx_destroy(&cache->mutex);
+	free(cache->path);
+	free(cache);
+}
+
+enum GpResult gp_metadata_cache_open(struct GpMetadataCache* cache, const char* path) {
+	size_t path_size = strlen(path);
+	char* cache_path = malloc(path_size + 1);
+	if (cache_path == NULL) return GP_RESULT_ERROR;
+	memcpy(cache_path, path, path_size + 1);
+
+	mtx_lock(&cache->mutex);
+	close_file_map(cache);
+	free(cache->path);
+	cache->path = cache_path;
+	enum GpResult result = open_file_map(cache);
+	mtx_unlock(&cache->mutex);
+
+	return result;
+}
+
+enum GpResult gp_metadata_cache_save(struct GpMetadataCache* cache) {
+	mtx_lock(&cache->mutex);
+
+	if (cache->path == NULL) {
+		mtx_unlock(&cache->mutex);
+		return GP_RESULT_ERROR;
+	}
+
+	if (cache->added.records_size == 0) {
+		mtx_unlock(&cache->mutex);
+		return GP_RESULT_OK;
+	}
+
+	struct GpMetadataTable merged = {0};
+	enum GpResult result = GP_RESULT_OK;
+
+	for (size_t i = 0; i < cache->added.records_size && result == GP_RESULT_OK; i++) {
+		const struct GpMetadataRecord* record = &cache->added.records[i];
+		const char* path = cache->added.pool + record->path_offset;
+		result = table_insert(&merged, record, path, (const uint8_t*)path + record->path_size);
+	}
+
+	for (size_t i = 0; i < cache->mapped.records_size && result == GP_RESULT_OK; i++) {
+		const struct GpMetadataRecord* record = &cache->mapped.records[i];
+		const char* path = cache->mapped.pool + record->path_offset;
+		if (table_find(&merged, record->hash, path, record->path_size) != NULL) continue;
+		result = table_insert(&merged, record, path, (const uint8_t*)path + record->path_size);
+	}
+
+	size_t path_size = strlen(cache->path);
+	char* temporary_path = malloc(path_size + sizeof(".tmp"));
+	if (temporary_path == NULL) result = GP_RESULT_ERROR;
+
+	if (result == GP_RESULT_OK) {
+		memcpy(temporary_path, cache->path, path_size);
+		memcpy(temporary_path + path_size, ".tmp", sizeof(".tmp"));
+		result = write_table(&merged, temporary_path);
+	}
+
+	if (result == GP_RESULT_OK) {
+		close_file_map(cache);
+#ifdef _WIN32
+		remove(cache->path);
+#endif
+		if (rename(temporary_path, cache->path) != 0) {
+			remove(temporary_path);
+			result = GP_RESULT_ERROR;
+		}
+		open_file_map(cache);
+	}
+
+	if (result == GP_RESULT_OK && cache->file_map != NULL) table_free(&cache->added);
+
+	free(temporary_path);
+	table_free(&merged);
+	mtx_unlock(&cache->mutex);
+
+	return result;
+}
+
+static void copy_loudness(const struct GpMetadataRecord* record, struct GpLoudnessInfo* loudness) {
+	loudness->integrated_loudness = record->integrated_loudness;
+	loudness->true_peak = record->true_peak;
+	loudness->loudness_range = record->loudness_range;
+}
+
+static enum GpResult get_key(const struct GpSource* source, struct GpMetadataRecord* record) {
+	*record = (struct GpMetadataRecord){0};
+	record->path_size = (uint32_t)source->size;
+	record->hash = hash_path(source->path, source->size);
+
+	return get_file_key(source, &record->file_size, &record->file_time);
+}
+
+static const struct GpMetadataRecord* find_record(const struct GpMetadataCache* cache,
+		const struct GpMetadataRecord* key, const char* path, const struct GpMetadataTable** table) {
+	*table = &cache->added;
+	const struct GpMetadataRecord* cached = table_find(*table, key->hash, path, key->path_size);
+	if (cached == NULL) {
+		*table = &cache->mapped;
+		cached = table_find(*table, key->hash, path, key->path_size);
+	}
+
+	if (cached == NULL || cached->file_size != key->file_size || cached->file_time != key->file_time) return NULL;
+	return cached;
+}
+
+static bool find_current(struct GpMetadataCache* cache, const struct GpSource* source,
+		const struct GpMetadataRecord* key, struct GpMetadataRecord* record) {
+	mtx_lock(&cache->mutex);
+	const struct GpMetadataTable* table;
+	const struct GpMetadataRecord* cached = find_record(cache, key, source->path, &table);
+	if (cached != NULL) *record = *cached;
+	mtx_unlock(&cache->mutex);
+
+	return cached != NULL;
+}
+
+static void merge_record(struct GpMetadataRecord* record, const struct GpMetadataRecord* cached) {
+	if ((record->flags & GP_METADATA_RECORD_INFO) == 0 && (cached->flags & GP_METADATA_RECORD_INFO) != 0) {
+		record->sample_rate = cached->sample_rate;
+		record->duration = cached->duration;
+		record->channels = cached->channels;
+		record->bits_per_sample = cached->bits_per_sample;
+		record->codec = cached->codec;
+	}
+
+	if ((record->flags & GP_METADATA_RECORD_LOUDNESS) == 0 && (cached->flags & GP_METADATA_RECORD_LOUDNESS) != 0) {
+		record->integrated_loudness = cached->integrated_loudness;
+		record->true_peak = cached->true_peak;
+		record->loudness_range = cached->loudness_range;
+	}
+
+	record->flags |= cached->flags;
+}
+
+static void store(struct GpMetadataCache* cache, const struct GpMetadataRecord* record, const char* path,
+		const uint8_t* seek_points) {
+	mtx_lock(&cache->mutex);
+
+	struct GpMetadataRecord merged = *record;
+	uint8_t* cached_seek_points = NULL;
+
+	const struct GpMetadataTable* table;
+	const struct GpMetadataRecord* cached = find_record(cache, record, path, &table);
+	if (cached != NULL) {
+		merge_record(&merged, cached);
+
+		size_t seek_points_bytes = (size_t)cached->seek_points_size * GP_SEEK_POINT_SIZE;
+		if (seek_points == NULL && seek_points_bytes > 0 && (cached_seek_points = malloc(seek_points_bytes)) != NULL) {
+			memcpy(cached_seek_points, table->pool + cached->path_offset + cached->path_size, seek_points_bytes);
+			merged.seek_points_size = cached->seek_points_size;
+			merged.seek_frame_offset = cached->seek_frame_offset;
+		}
+	}
+
+	table_insert(&cache->added, &merged, path, seek_points != NULL ? seek_points : cached_seek_points);
+	mtx_unlock(&cache->mutex);
+
+	free(cached_seek_points);
+}
+
+static enum GpResult lookup(struct GpMetadataCache* cache, const struct GpSource* source, bool probe,
+		struct GpSourceInfo* info) {
+	struct GpMetadataRecord record;
+	if (get_key(source, &record) != GP_RESULT_OK) return GP_RESULT_ERROR;
+
+	struct GpMetadataRecord cached;
+	if (!probe && find_current(cache, source, &record, &cached) && (cached.flags & GP_METADATA_RECORD_INFO) != 0) {
+		copy_info(&cached, info);
+		return GP_RESULT_OK;
+	}
+
+	if (probe_source(source, &record) != GP_RESULT_OK) return GP_RESULT_ERROR;
+	record.flags = GP_METADATA_RECORD_INFO;
+
+	copy_info(&record, info);
+	store(cache, &record, source->path, NULL);
+
+	return GP_RESULT_OK;
+}
+
+static enum GpResult analyze(struct GpMetadataCache* cache, const struct GpSource* source, bool read_only,
+		struct GpLoudnessInfo* loudness) {
+	struct GpMetadataRecord record;
+	if (get_key(source, &record) != GP_RESULT_OK) return GP_RESULT_ERROR;
+
+	struct GpMetadataRecord cached;
+	bool is_current = find_current(cache, source, &record, &cached);
+	if (is_current && (cached.flags & GP_METADATA_RECORD_LOUDNESS) != 0) {
+		copy_loudness(&cached, loudness);
+		return GP_RESULT_OK;
+	}
+
+	if (read_only) return GP_RESULT_ERROR;
+
+	if (!is_current || (cached.flags & GP_METADATA_RECORD_INFO) == 0) {
+		if (probe_source(source, &record) != GP_RESULT_OK) return GP_RESULT_ERROR;
+		record.flags = GP_METADATA_RECORD_INFO;
+	}
+
+	struct GpLoudnessInfo analyzed;
+	if (gp_loudness_analyze(source, &analyzed) != GP_RESULT_OK) return GP_RESULT_ERROR;
+
+	record.flags |= GP_METADATA_RECORD_LOUDNESS;
+	record.integrated_loudness = (float)analyzed.integrated_loudness;
+	record.true_peak = (float)analyzed.true_peak;
+	record.loudness_range = (float)analyzed.loudness_range;
+
+	copy_loudness(&record, loudness);
+	store(cache, &record, source->path, NULL);
+
+	return GP_RESULT_OK;
+}
+
+enum GpResult gp_metadata_cache_get(struct GpMetadataCache* cache, const char* path, struct GpSourceInfo* info) {
+	struct GpSource* source = gp_new_source(path);
+	if (source == NULL) return GP_RESULT_ERROR;
+
+	enum GpResult result = lookup(cache, source, false, info);
+	gp_free_source(source);
+
+	return result;
+}
+
+enum GpResult gp_metadata_cache_probe(struct GpMetadataCache* cache, const char* path, struct GpSourceInfo* info) {
+	struct GpSource* source = gp_new_source(path);
+	if (source == NULL) return GP_RESULT_ERROR;
+
+	enum GpResult result = lookup(cache, source, true, info);
+	gp_free_source(source);
+
+	return result;
+}
+
+enum GpResult gp_metadata_cache_get_loudness(struct GpMetadataCache* cache, const char* path,
+		struct GpLoudnessInfo* loudness) {
+	struct GpSource* source = gp_new_source(path);
+	if (source == NULL) return GP_RESULT_ERROR;
+
+	enum GpResult result = analyze(cache, source, true, loudness);
+	gp_free_source(source);
+
+	return result;
+}
+
+enum GpResult gp_metadata_cache_analyze(struct GpMetadataCache* cache, const char* path,
+		struct GpLoudnessInfo* loudness) {
+	struct GpSource* source = gp_new_source(path);
+	if (source == NULL) return GP_RESULT_ERROR;
+
+	enum GpResult result = analyze(cache, source, false, loudness);
+	gp_free_source(source);
+
+	return result;
+}
+
+uint8_t* gp_metadata_cache_get_seek_points(struct GpMetadataCache* cache, const struct GpSource* source,
+		uint32_t frame_offset, size_t* seek_points_size) {
+	*seek_points_size = 0;
+
+	struct GpMetadataRecord key;
+	if (get_key(source, &key) != GP_RESULT_OK) return NULL;
+
+	mtx_lock(&cache->mutex);
+
+	uint8_t* seek_points = NULL;
+	const struct GpMetadataTable* table;
+	const struct GpMetadataRecord* cached = find_record(cache, &key, source->path, &table);
+	if (cached != NULL && cached->seek_points_size > 0 && cached->seek_frame_offset == frame_offset) {
+		size_t seek_points_bytes = (size_t)cached->seek_points_size * GP_SEEK_POINT_SIZE;
+		seek_points = malloc(seek_points_bytes);
+		if (seek_points != NULL) {
+			memcpy(seek_points, table->pool + cached->path_offset + cached->path_size, seek_points_bytes);
+			*seek_points_size = cached->seek_points_size;
+		}
+	}
+
+	mtx_unlock(&cache->mutex);
+
+	return seek_points;
+}
+
+void gp_metadata_cache_set_seek_points(struct GpMetadataCache* cache, const struct GpSource* source,
+		uint32_t frame_offset, const uint8_t* seek_points, size_t seek_points_size) {
+	struct GpMetadataRecord record;
+	if (seek_points_size == 0 || get_key(source, &record) != GP_RESULT_OK) return;
+
+	record.seek_points_size = (uint32_t)seek_points_size;
+	record.seek_frame_offset = frame_offset;
+	store(cache, &record, source->path, seek_points);
+}
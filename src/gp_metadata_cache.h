@@ -0,0 +1,73 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <threads.h>
+#include "grass_player.h"
+#include "gp_file_map.h"
+
+#define GP_METADATA_CACHE_MAGIC 0x434d5047
+#define GP_METADATA_CACHE_VERSION 3
+#define GP_METADATA_RECORD_INFO 1
+#define GP_METADATA_RECORD_LOUDNESS 2
+#define GP_SEEK_POINT_SIZE 18
+
+struct GpMetadataCacheHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t records_size;
+  uint64_t buckets_size;
+  uint64_t pool_size;
+};
+
+struct GpMetadataRecord {
+  uint64_t hash;
+  uint64_t file_size;
+  int64_t file_time;
+  uint64_t path_offset;
+  uint32_t path_size;
+  uint32_t sample_rate;
+  double duration;
+  uint16_t channels;
+  uint16_t bits_per_sample;
+  uint32_t codec;
+  uint32_t flags;
+  float integrated_loudness;
+  float true_peak;
+  float loudness_range;
+  uint32_t seek_points_size;
+  uint32_t seek_frame_offset;
+};
+
+struct GpMetadataTable {
+  struct GpMetadataRecord* records;
+  size_t records_size;
+  size_t records_capacity;
+  uint32_t* buckets;
+  size_t buckets_size;
+  char* pool;
+  size_t pool_size;
+  size_t pool_capacity;
+};
+
+struct GpMetadataCache {
+  struct GpFileMap* file_map;
+  struct GpMetadataTable mapped;
+  struct GpMetadataTable added;
+  char* path;
+  mtx_t mutex;
+};
+
+struct GpMetadataCache* gp_new_metadata_cache(void);
+void gp_free_metadata_cache(struct GpMetadataCache* cache);
+enum GpResult gp_metadata_cache_open(struct GpMetadataCache* cache, const char* path);
+enum GpResult gp_metadata_cache_save(struct GpMetadataCache* cache);
+enum GpResult gp_metadata_cache_get(struct GpMetadataCache* cache, const char* path, struct GpSourceInfo* info);
+enum GpResult gp_metadata_cache_probe(struct GpMetadataCache* cache, const char* path, struct GpSourceInfo* info);
+enum GpResult gp_metadata_cache_get_loudness(struct GpMetadataCache* cache, const char* path,
+		struct GpLoudnessInfo* loudness);
+enum GpResult gp_metadata_cache_analyze(struct GpMetadataCache* cache, const char* path,
+		struct GpLoudnessInfo* loudness);
+uint8_t* gp_metadata_cache_get_seek_points(struct GpMetadataCache* cache, const struct GpSource* source,
+		uint32_t frame_offset, size_t* seek_points_size);
+void gp_metadata_cache_set_seek_points(struct GpMetadataCache* cache, const struct GpSource* source,
+		uint32_t frame_offset, const uint8_t* seek_points, size_t seek_points_size);
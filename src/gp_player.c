@@ -3,130 +3,312 @@
 #include "bassmix.h"
 #include <stdbool.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "gp_audio_output.h"
+#include "gp_clock.h"
+#include "gp_command.h"
+#include "gp_file_map.h"
+#include "gp_gain.h"
+#include "gp_plugin.h"
+#include "gp_scanner.h"
+#include "gp_seek_index.h"
+#include "gp_wav.h"
 
-static struct GpPlayer* player = NULL;
+struct GpSourcePath {
+  size_t capacity;
+  char path[];
+};
 
-void load_stream(void);
-void handle_track_end_sync(void);
+static struct GpPlayer* default_player = NULL;
+static tss_t source_path_key;
+static bool source_path_key_created = false;
+static once_flag source_path_once = ONCE_FLAG_INIT;
 
-enum GpResult gp_init(enum GpSampleRate sample_rate) {
-	if (player != NULL) return GP_RESULT_ERROR;
+int run_owner_thread(void* arg);
+enum GpPlaybackState get_playback_state(struct GpPlayer* player);
+enum GpResult post_command(struct GpPlayer* player, struct GpCommand command);
+void post_request(struct GpPlayer* player, enum GpRequest request);
+enum GpResult reserve_queued_sources(struct GpPlayer* player, size_t index, size_t inserted_size,
+		size_t removed_size);
+void release_queued_sources(struct GpPlayer* player, size_t inserted_size, size_t removed_size);
+void apply_command(struct GpPlayer* player, const struct GpCommand* command);
+void apply_preload(struct GpPlayer* player);
+void apply_advance(struct GpPlayer* player);
+void load_stream(struct GpPlayer* player, size_t source_index);
+void attach_stream(struct GpPlayer* player, size_t source_index, uint32_t stream_handle);
+size_t get_next_source_index(struct GpPlayer* player);
+void discard_next_stream(struct GpPlayer* player);
+void update_next_stream(struct GpPlayer* player);
+void set_lookahead_sync(struct GpPlayer* player);
+void CALLBACK handle_lookahead_sync(HSYNC sync, DWORD channel, DWORD data, void* user);
+void CALLBACK handle_track_end_sync(HSYNC sync, DWORD channel, DWORD data, void* user);
+void publish_snapshot(struct GpPlayer* player);
+void CALLBACK handle_seek_sync(HSYNC sync, DWORD channel, DWORD data, void* user);
+void CALLBACK handle_position_sync(HSYNC sync, DWORD channel, DWORD data, void* user);
+void push_event(struct GpPlayer* player, enum GpEventType type, size_t source_index, double position);
+void set_stream_syncs(struct GpPlayer* player, uint32_t stream_handle);
+void set_position_sync(struct GpPlayer* player, uint32_t stream_handle, double position);
+void set_crossfade_sync(struct GpPlayer* player);
+void CALLBACK handle_crossfade_sync(HSYNC sync, DWORD channel, DWORD data, void* user);
+void remove_fading_stream(struct GpPlayer* player);
+void publish_handover_stats(struct GpPlayer* player, double handover_start, bool preloaded);
+uint32_t create_mixer_stream(struct GpPlayer* player, uint32_t sample_rate, struct GpInitStats* stats);
+bool matches_mixer_rate(struct GpPlayer* player, uint32_t stream_handle);
+void CALLBACK handle_mixer_dsp(HDSP dsp, DWORD channel, void* buffer, DWORD length, void* user);
+uint64_t get_audible_position(struct GpPlayer* player, uint32_t stream_handle);
+void play_output(struct GpPlayer* player);
+void record_first_audio(struct GpPlayer* player);
+void pause_output(struct GpPlayer* player);
+void stop_output(struct GpPlayer* player);
+void flush_zones(struct GpPlayer* player);
 
-	if (gp_audio_output_init(sample_rate) != GP_RESULT_OK) {
-		return GP_RESULT_ERROR;
-	}
+void free_player(struct GpPlayer* player) {
+	gp_free_metadata_cache(player->metadata_cache);
+	gp_event_queue_destroy(&player->events);
+	gp_ring_destroy(&player->commands);
+	cnd_destroy(&player->applied_condition);
+	cnd_destroy(&player->owner_condition);
+	mtx_destroy(&player->owner_mutex);
+	mtx_destroy(&player->sources_mutex);
+	free(player);
+}
 
-	player = (struct GpPlayer*)malloc(sizeof(struct GpPlayer));
+struct GpPlayer* gp_player_create(const struct GpInitOptions* options) {
+	if (options == NULL || options->sample_rate == 0) return NULL;
 
-	player->mixer_stream_handle = BASS_Mixer_StreamCreate(sample_rate, 2,
-			BASS_MIXER_END);
+	uint32_t sample_rate = options->sample_rate;
+	bool render = options->output_mode == GP_OUTPUT_MODE_RENDER;
+	bool native_rate = options->output_mode == GP_OUTPUT_MODE_NATIVE_RATE;
+	bool zoned = options->output_mode == GP_OUTPUT_MODE_ZONES;
+	bool sink_output = options->output_mode == GP_OUTPUT_MODE_SINK;
+	bool decode_output = zoned || sink_output;
+	int device = render || decode_output ? GP_AUDIO_OUTPUT_NO_SOUND_DEVICE : GP_AUDIO_OUTPUT_DEFAULT_DEVICE;
+	double init_start = gp_clock_now();
+	struct GpInitStats init_stats = {0};
 
-	if (player->mixer_stream_handle == 0) {
-		free(player);
-		player = NULL;
-		return GP_RESULT_ERROR;
+	if (gp_audio_output_init(device, sample_rate, native_rate, options->latency_profile,
+			&init_stats.device_init_seconds) != GP_RESULT_OK) {
+		return NULL;
+	}
+
+	struct GpPlayer* player = (struct GpPlayer*)calloc(1, sizeof(struct GpPlayer));
+	if (player == NULL) {
+		gp_audio_output_close();
+		return NULL;
 	}
 
-	uint32_t set_sync_result = BASS_ChannelSetSync(player->mixer_stream_handle,
-			BASS_SYNC_END | BASS_SYNC_MIXTIME | BASS_SYNC_THREAD, 0,
-			(void (*)(HSYNC, DWORD, DWORD, void*))&handle_track_end_sync, player);
+	player->events.fd = -1;
+	if (gp_ring_init(&player->commands, GP_COMMAND_QUEUE_CAPACITY, sizeof(struct GpCommand)) != GP_RESULT_OK
+			|| gp_event_queue_init(&player->events) != GP_RESULT_OK
+			|| (player->metadata_cache = gp_new_metadata_cache()) == NULL
+			|| mtx_init(&player->sources_mutex, mtx_plain) != thrd_success
+			|| mtx_init(&player->owner_mutex, mtx_plain) != thrd_success
+			|| cnd_init(&player->owner_condition) != thrd_success
+			|| cnd_init(&player->applied_condition) != thrd_success) {
+		free_player(player);
+		gp_audio_output_close();
+		return NULL;
+	}
 
-	if (set_sync_result == 0) {
-		BASS_StreamFree(player->mixer_stream_handle);
-		free(player);
-		player = NULL;
-		return GP_RESULT_ERROR;
+	player->render = render;
+	player->zoned = zoned;
+	player->sink_output = sink_output;
+	player->decode_output = decode_output;
+	gp_gain_stage_init(&player->gain_stage, sample_rate);
+	gp_tap_init(&player->tap);
+	player->mixer_stream_handle = create_mixer_stream(player, sample_rate, &init_stats);
+
+	if (player->mixer_stream_handle == 0) {
+		free_player(player);
+		gp_audio_output_close();
+		return NULL;
 	}
 
 	player->stream_handle = 0;
 	player->sources = NULL;
+	player->sources_size = 0;
+	player->queued_sources_size = 0;
 	player->source_index = 0;
+	player->current_removed = false;
+	player->sample_rate = sample_rate;
+	player->native_rate = native_rate;
+	player->source_mode = GP_SOURCE_MODE_FILE;
+	player->next_source_index = 0;
+	player->next_stream_handle = 0;
+	player->lookahead_generation = 0;
+	player->position_interval = GP_POSITION_INTERVAL_SECONDS;
+	player->position_sync = 0;
+	player->crossfade_seconds = 0;
+	player->crossfade_sync = 0;
+	player->fading_stream_handle = 0;
+	player->replay_gain_mode = GP_REPLAY_GAIN_MODE_OFF;
+	player->posted_commands = 0;
+	player->applied_commands = 0;
+	player->requests = 0;
+	player->advance_stream_handle = 0;
+	player->advance_pending = false;
+	player->advance_time = 0;
+	player->zones_size = 0;
+	player->queued_zones_size = 0;
+	player->output_playback_state = GP_PLAYBACK_STATE_STOPPED;
+	player->sink = NULL;
+	player->play_time = 0;
+	player->first_audio_pending = false;
+	player->first_audio_nanoseconds = 0;
 
-	return GP_RESULT_OK;
+	if (thrd_create(&player->owner_thread, run_owner_thread, player) != thrd_success) {
+		BASS_StreamFree(player->mixer_stream_handle);
+		free_player(player);
+		gp_audio_output_close();
+		return NULL;
+	}
+
+	init_stats.init_seconds = gp_clock_now() - init_start;
+	player->init_stats = init_stats;
+
+	return player;
 }
 
-enum GpResult gp_close(void) {
+enum GpResult gp_player_destroy(struct GpPlayer* player) {
 	if (player == NULL) return GP_RESULT_OK;
 
+	post_command(player, (struct GpCommand){.type = GP_COMMAND_QUIT});
+	thrd_join(player->owner_thread, NULL);
+
+	discard_next_stream(player);
+	for (size_t i = 0; i < player->zones_size; i++) gp_zone_close(player->zones[i]);
+	gp_sink_close(player->sink);
+
 	if (!BASS_StreamFree(player->mixer_stream_handle)) {
 		return GP_RESULT_ERROR;
 	}
 	gp_free_source_list(player->sources);
-	free(player);
+	if (player->metadata_cache->path != NULL) gp_metadata_cache_save(player->metadata_cache);
+	free_player(player);
 
 	if (gp_audio_output_close() != GP_RESULT_OK) {
 		return GP_RESULT_ERROR;
 	}
 
-	player = NULL;
-
 	return GP_RESULT_OK;
 }
 
-enum GpResult gp_set_sources(const char** sources, size_t sources_size) {
-	if (player == NULL) return GP_RESULT_ERROR;
+void gp_player_flush(struct GpPlayer* player) {
+	if (player == NULL) return;
 
-	if (player->stream_handle != 0 && !BASS_Mixer_ChannelRemove(player->stream_handle)) {
-		return GP_RESULT_ERROR;
+	size_t posted_commands = player->posted_commands;
+	if (player->applied_commands >= posted_commands) return;
+
+	mtx_lock(&player->owner_mutex);
+	while (player->applied_commands < posted_commands) {
+		cnd_wait(&player->applied_condition, &player->owner_mutex);
 	}
+	mtx_unlock(&player->owner_mutex);
+}
 
-	gp_free_source_list(player->sources);
+enum GpResult gp_player_set_sources(struct GpPlayer* player, const char** sources, size_t sources_size) {
+	if (player == NULL) return GP_RESULT_ERROR;
 
-	player->sources = gp_new_source_list(sources, sources_size);
-	player->source_index = 0;
-	player->stream_handle = 0;
+	struct GpSourceList* source_list = gp_new_source_list(sources, sources_size);
+	if (source_list == NULL) return GP_RESULT_ERROR;
 
-	return GP_RESULT_OK;
+	player->queued_sources_size = sources_size;
+
+	return post_command(player, (struct GpCommand){.type = GP_COMMAND_SET_SOURCES, .sources = source_list});
 }
 
-void gp_play(void) {
-	if (player == NULL || player->sources == NULL) return;
+enum GpResult insert_sources(struct GpPlayer* player, size_t index, const char** sources, size_t sources_size) {
+	if (player == NULL) return GP_RESULT_ERROR;
 
-	if (player->stream_handle == 0) {
-		load_stream();
+	struct GpSourceList* source_list = gp_new_source_list(sources, sources_size);
+	if (source_list == NULL) return GP_RESULT_ERROR;
+
+	if (reserve_queued_sources(player, index, sources_size, 0) != GP_RESULT_OK) {
+		gp_free_source_list(source_list);
+		return GP_RESULT_ERROR;
 	}
 
-	BASS_ChannelPlay(player->mixer_stream_handle, false);
+	return post_command(player, (struct GpCommand){
+			.type = GP_COMMAND_INSERT_SOURCES,
+			.insert = {index, source_list}
+	});
+}
+
+enum GpResult gp_player_insert_sources(struct GpPlayer* player, size_t index, const char** sources,
+		size_t sources_size) {
+	if (index == SIZE_MAX) return GP_RESULT_ERROR;
 
+	return insert_sources(player, index, sources, sources_size);
 }
 
-void gp_stop(void) {
-	if (player == NULL) return;
+enum GpResult gp_player_append_sources(struct GpPlayer* player, const char** sources, size_t sources_size) {
+	return insert_sources(player, SIZE_MAX, sources, sources_size);
+}
 
-	BASS_ChannelStop(player->mixer_stream_handle);
-	BASS_ChannelSetPosition(player->mixer_stream_handle, 0, BASS_POS_BYTE);
+enum GpResult gp_player_remove_sources(struct GpPlayer* player, size_t index, size_t sources_size) {
+	if (player == NULL || index == SIZE_MAX) return GP_RESULT_ERROR;
 
-	BASS_Mixer_ChannelRemove(player->stream_handle);
+	if (reserve_queued_sources(player, index, 0, sources_size) != GP_RESULT_OK) return GP_RESULT_ERROR;
 
-	player->stream_handle = 0;
-	player->source_index = 0;
+	return post_command(player, (struct GpCommand){
+			.type = GP_COMMAND_REMOVE_SOURCES,
+			.remove = {index, sources_size}
+	});
 }
 
-void gp_pause(void) {
+enum GpResult gp_player_move_source(struct GpPlayer* player, size_t from_index, size_t to_index) {
+	if (player == NULL) return GP_RESULT_ERROR;
+
+	size_t queued_sources_size = player->queued_sources_size;
+	if (from_index >= queued_sources_size || to_index >= queued_sources_size) return GP_RESULT_ERROR;
+
+	return post_command(player, (struct GpCommand){
+			.type = GP_COMMAND_MOVE_SOURCE,
+			.move = {from_index, to_index}
+	});
+}
+
+void gp_player_play(struct GpPlayer* player) {
 	if (player == NULL) return;
 
-	BASS_ChannelPause(player->mixer_stream_handle);
+	atomic_store_explicit(&player->play_time, gp_clock_now(), memory_order_relaxed);
+	atomic_store_explicit(&player->first_audio_pending, true, memory_order_release);
+	post_command(player, (struct GpCommand){.type = GP_COMMAND_PLAY});
 }
 
-void gp_seek(double seconds) {
-	if (player == NULL || player->stream_handle == 0) return;
+void gp_player_stop(struct GpPlayer* player) {
+	post_command(player, (struct GpCommand){.type = GP_COMMAND_STOP});
+}
 
-	uint64_t position = BASS_ChannelSeconds2Bytes(player->stream_handle, seconds);
-	BASS_Mixer_ChannelSetPosition(player->stream_handle, position,
-			BASS_POS_BYTE | BASS_MIXER_CHAN_NORAMPIN | BASS_POS_MIXER_RESET);
+void gp_player_pause(struct GpPlayer* player) {
+	post_command(player, (struct GpCommand){.type = GP_COMMAND_PAUSE});
 }
 
-void gp_skip_to(size_t source_index) {
-	if (player == NULL || player->sources == NULL || source_index >= player->sources->size) return;
+void gp_player_seek(struct GpPlayer* player, double seconds) {
+	post_command(player, (struct GpCommand){.type = GP_COMMAND_SEEK, .seconds = seconds});
+}
 
-	player->source_index = source_index;
-	load_stream();
+void gp_player_skip_to(struct GpPlayer* player, size_t source_index) {
+	if (player == NULL || source_index >= player->queued_sources_size) return;
+
+	post_command(player, (struct GpCommand){.type = GP_COMMAND_SKIP_TO, .source_index = source_index});
 }
 
-enum GpPlaybackState gp_get_playback_state(void) {
+enum GpPlaybackState gp_player_get_playback_state(struct GpPlayer* player) {
+	gp_player_flush(player);
+
 	if (player == NULL) return GP_PLAYBACK_STATE_STOPPED;
 
+	return get_playback_state(player);
+}
+
+enum GpPlaybackState get_playback_state(struct GpPlayer* player) {
+	if (player->decode_output) {
+		if (BASS_ChannelIsActive(player->mixer_stream_handle) == BASS_ACTIVE_STOPPED) return GP_PLAYBACK_STATE_STOPPED;
+		return player->output_playback_state;
+	}
+
 	switch (BASS_ChannelIsActive(player->mixer_stream_handle)) {
 	case BASS_ACTIVE_PLAYING: return GP_PLAYBACK_STATE_PLAYING;
 	case BASS_ACTIVE_PAUSED: return GP_PLAYBACK_STATE_PAUSED;
@@ -134,78 +316,1551 @@ enum GpPlaybackState gp_get_playback_state(void) {
 	}
 }
 
-double gp_get_source_position(void) {
-	if (player == NULL || player->stream_handle == 0) return 0;
+double gp_player_get_source_position(struct GpPlayer* player) {
+	gp_player_flush(player);
+
+	if (player == NULL) return 0;
 
-	uint64_t position = BASS_ChannelGetPosition(player->stream_handle, BASS_POS_BYTE);
-	return BASS_ChannelBytes2Seconds(player->stream_handle, position);
+	uint32_t stream_handle = player->stream_handle;
+	if (stream_handle == 0) return 0;
+
+	return BASS_ChannelBytes2Seconds(stream_handle, get_audible_position(player, stream_handle));
 }
 
-double gp_get_source_duration(void) {
+uint64_t gp_player_get_source_position_frames(struct GpPlayer* player) {
+	gp_player_flush(player);
+
+	if (player == NULL) return 0;
+
+	uint32_t stream_handle = player->stream_handle;
+	BASS_CHANNELINFO info;
+	if (stream_handle == 0 || !BASS_ChannelGetInfo(stream_handle, &info) || info.chans == 0) return 0;
+
+	return get_audible_position(player, stream_handle) / (info.chans * sizeof(float));
+}
+
+double gp_player_get_source_duration(struct GpPlayer* player) {
+	gp_player_flush(player);
+
+	if (player == NULL) return 0;
+
+	uint32_t stream_handle = player->stream_handle;
+	if (stream_handle == 0) return 0;
+
+	uint64_t length = BASS_ChannelGetLength(stream_handle, BASS_POS_BYTE);
+	return BASS_ChannelBytes2Seconds(stream_handle, length);
+}
+
+float gp_player_get_volume(struct GpPlayer* player) {
+	gp_player_flush(player);
+
+	if (player == NULL) return 0;
+
+	return atomic_load_explicit(&player->gain_stage.volume, memory_order_relaxed);
+}
+
+void gp_player_set_volume(struct GpPlayer* player, float volume) {
+	post_command(player, (struct GpCommand){.type = GP_COMMAND_SET_VOLUME, .volume = volume});
+}
+
+void gp_player_set_replay_gain_mode(struct GpPlayer* player, enum GpReplayGainMode replay_gain_mode) {
+	post_command(player, (struct GpCommand){
+			.type = GP_COMMAND_SET_REPLAY_GAIN_MODE,
+			.replay_gain_mode = replay_gain_mode
+	});
+}
+
+size_t gp_player_get_source_path(struct GpPlayer* player, char* path, size_t path_size) {
+	gp_player_flush(player);
+
+	if (path != NULL && path_size > 0) path[0] = '\0';
 	if (player == NULL || player->stream_handle == 0) return 0;
 
-	uint64_t length = BASS_ChannelGetLength(player->stream_handle, BASS_POS_BYTE);
-	return BASS_ChannelBytes2Seconds(player->stream_handle, length);
+	size_t source_path_size = 0;
+
+	mtx_lock(&player->sources_mutex);
+	size_t source_index = player->source_index;
+	if (player->sources != NULL && source_index < player->sources->size) {
+		const char* source_path = gp_source_list_get(player->sources, source_index).path;
+		source_path_size = strlen(source_path);
+		if (path != NULL && path_size > 0) {
+			size_t copy_size = source_path_size < path_size ? source_path_size : path_size - 1;
+			memcpy(path, source_path, copy_size);
+			path[copy_size] = '\0';
+		}
+	}
+	mtx_unlock(&player->sources_mutex);
+
+	return source_path_size;
 }
 
-float gp_get_volume(void) {
+size_t gp_player_get_source_index(struct GpPlayer* player) {
+	gp_player_flush(player);
+
 	if (player == NULL || player->stream_handle == 0) return 0;
 
-	float volume;
-	BASS_ChannelGetAttribute(player->stream_handle, BASS_ATTRIB_VOL, &volume);
-	return volume;
+	return player->source_index;
 }
 
-void gp_set_volume(float volume) {
-	if (player == NULL || player->stream_handle == 0) return;
+size_t gp_player_get_sources_size(struct GpPlayer* player) {
+	gp_player_flush(player);
 
-	BASS_ChannelSetAttribute(player->stream_handle, BASS_ATTRIB_VOL, volume);
+	if (player == NULL) return 0;
+
+	return player->sources_size;
 }
 
-const char* gp_get_source_path(void) {
-	if (player == NULL || player->sources == NULL || player->stream_handle == 0) return NULL;
+void gp_player_set_source_mode(struct GpPlayer* player, enum GpSourceMode source_mode) {
+	post_command(player, (struct GpCommand){.type = GP_COMMAND_SET_SOURCE_MODE, .source_mode = source_mode});
+}
 
-	return player->sources->list[player->source_index]->path;
+void gp_player_set_crossfade(struct GpPlayer* player, double seconds) {
+	post_command(player, (struct GpCommand){.type = GP_COMMAND_SET_CROSSFADE, .seconds = seconds > 0 ? seconds : 0});
 }
 
-size_t gp_get_source_index(void) {
-	if (player == NULL || player->sources == NULL || player->stream_handle == 0) return 0;
+enum GpResult gp_player_get_handover_stats(struct GpPlayer* player, struct GpHandoverStats* stats) {
+	if (player == NULL || stats == NULL) return GP_RESULT_ERROR;
 
-	return player->source_index;
+	unsigned sequence;
+	do {
+		sequence = atomic_load_explicit(&player->handover_sequence, memory_order_acquire);
+		uint64_t nanoseconds = atomic_load_explicit(&player->handover_nanoseconds, memory_order_relaxed);
+		stats->seconds = (double)nanoseconds / 1e9;
+		stats->preloaded = atomic_load_explicit(&player->handover_preloaded, memory_order_relaxed);
+		atomic_thread_fence(memory_order_acquire);
+	} while ((sequence & 1) != 0
+			|| sequence != atomic_load_explicit(&player->handover_sequence, memory_order_relaxed));
+
+	return GP_RESULT_OK;
 }
 
-size_t gp_get_sources_size(void) {
-	if (player == NULL || player->sources == NULL) return 0;
+enum GpResult gp_player_get_init_stats(struct GpPlayer* player, struct GpInitStats* stats) {
+	if (player == NULL || stats == NULL) return GP_RESULT_ERROR;
 
-	return player->sources->size;
+	*stats = player->init_stats;
+	stats->plugin_load_seconds = gp_plugin_get_load_seconds();
+	stats->first_audio_seconds =
+			(double)atomic_load_explicit(&player->first_audio_nanoseconds, memory_order_relaxed) / 1e9;
+
+	return GP_RESULT_OK;
 }
 
-void load_stream(void) {
-	if (player->sources == NULL) return;
+enum GpResult gp_player_get_snapshot(struct GpPlayer* player, struct GpSnapshot* snapshot) {
+	if (player == NULL || snapshot == NULL) return GP_RESULT_ERROR;
 
-	BASS_Mixer_ChannelRemove(player->stream_handle);
+	unsigned sequence;
+	double time;
+	do {
+		sequence = atomic_load_explicit(&player->snapshot_sequence, memory_order_acquire);
+		snapshot->playback_state = atomic_load_explicit(&player->snapshot_playback_state, memory_order_relaxed);
+		snapshot->source_index = atomic_load_explicit(&player->snapshot_source_index, memory_order_relaxed);
+		snapshot->sources_size = atomic_load_explicit(&player->snapshot_sources_size, memory_order_relaxed);
+		snapshot->source_position = atomic_load_explicit(&player->snapshot_position, memory_order_relaxed);
+		snapshot->source_duration = atomic_load_explicit(&player->snapshot_duration, memory_order_relaxed);
+		snapshot->volume = atomic_load_explicit(&player->snapshot_volume, memory_order_relaxed);
+		time = atomic_load_explicit(&player->snapshot_time, memory_order_relaxed);
+		atomic_thread_fence(memory_order_acquire);
+	} while ((sequence & 1) != 0
+			|| sequence != atomic_load_explicit(&player->snapshot_sequence, memory_order_relaxed));
 
-	struct GpSource* source = player->sources->list[player->source_index];
+	if (!player->render && snapshot->playback_state == GP_PLAYBACK_STATE_PLAYING) {
+		snapshot->source_position += gp_clock_now() - time;
+		if (snapshot->source_position > snapshot->source_duration) {
+			snapshot->source_position = snapshot->source_duration;
+		}
+	}
 
-	player->stream_handle = BASS_StreamCreateFile(FALSE,
-			source->wpath,
-			0,
-			0,
-			BASS_STREAM_DECODE | BASS_SAMPLE_FLOAT | BASS_UNICODE);
+	return GP_RESULT_OK;
+}
 
-	BASS_Mixer_StreamAddChannel(player->mixer_stream_handle, player->stream_handle,
-			BASS_MIXER_NORAMPIN | BASS_STREAM_AUTOFREE);
+enum GpResult gp_player_get_output_config(struct GpPlayer* player, struct GpOutputConfig* config) {
+	if (player == NULL || config == NULL) return GP_RESULT_ERROR;
 
-	BASS_ChannelSetPosition(player->mixer_stream_handle, 0, BASS_POS_BYTE);
+	gp_audio_output_get_config(config);
+
+	return GP_RESULT_OK;
 }
 
-void handle_track_end_sync(void) {
-	if (player->source_index == player->sources->size - 1) {
-		player->source_index = 0;
-		player->stream_handle = 0;
-		return;
+enum GpResult gp_player_get_source_info(struct GpPlayer* player, size_t index, struct GpSourceInfo* info) {
+	gp_player_flush(player);
+
+	if (player == NULL || info == NULL) return GP_RESULT_ERROR;
+
+	char* path = NULL;
+
+	mtx_lock(&player->sources_mutex);
+	if (player->sources != NULL && index < player->sources->size) {
+		struct GpSource source = gp_source_list_get(player->sources, index);
+		path = malloc(source.size + 1);
+		if (path != NULL) memcpy(path, source.path, source.size + 1);
+	}
+	mtx_unlock(&player->sources_mutex);
+
+	if (path == NULL) return GP_RESULT_ERROR;
+
+	enum GpResult result = gp_metadata_cache_get(player->metadata_cache, path, info);
+	free(path);
+
+	return result;
+}
+
+enum GpResult gp_player_open_metadata_cache(struct GpPlayer* player, const char* path) {
+	if (player == NULL || path == NULL) return GP_RESULT_ERROR;
+
+	return gp_metadata_cache_open(player->metadata_cache, path);
+}
+
+enum GpResult gp_player_save_metadata_cache(struct GpPlayer* player) {
+	if (player == NULL) return GP_RESULT_ERROR;
+
+	return gp_metadata_cache_save(player->metadata_cache);
+}
+
+enum GpResult gp_player_scan(struct GpPlayer* player, const char** paths, size_t paths_size, size_t threads_size,
+		GpScanCallback callback, void* user) {
+	if (player == NULL) return GP_RESULT_ERROR;
+
+	return gp_scanner_run(player->metadata_cache, paths, paths_size, threads_size, callback, user);
+}
+
+enum GpResult gp_player_get_source_loudness(struct GpPlayer* player, size_t index, struct GpLoudnessInfo* loudness) {
+	gp_player_flush(player);
+
+	if (player == NULL || loudness == NULL) return GP_RESULT_ERROR;
+
+	char* path = NULL;
+
+	mtx_lock(&player->sources_mutex);
+	if (player->sources != NULL && index < player->sources->size) {
+		struct GpSource source = gp_source_list_get(player->sources, index);
+		path = malloc(source.size + 1);
+		if (path != NULL) memcpy(path, source.path, source.size + 1);
+	}
+	mtx_unlock(&player->sources_mutex);
+
+	if (path == NULL) return GP_RESULT_ERROR;
+
+	enum GpResult result = gp_metadata_cache_get_loudness(player->metadata_cache, path, loudness);
+	free(path);
+
+	return result;
+}
+
+enum GpResult gp_player_analyze(struct GpPlayer* player, const char** paths, size_t paths_size, size_t threads_size,
+		GpAnalysisCallback callback, void* user) {
+	if (player == NULL) return GP_RESULT_ERROR;
+
+	return gp_scanner_analyze(player->metadata_cache, paths, paths_size, threads_size, callback, user);
+}
+
+enum GpResult gp_player_get_pcm(struct GpPlayer* player, float* frames, size_t frames_size) {
+	if (player == NULL) return GP_RESULT_ERROR;
+
+	return gp_tap_read(&player->tap, frames, frames_size);
+}
+
+enum GpResult gp_player_get_levels(struct GpPlayer* player, size_t frames_size, struct GpLevels* levels) {
+	if (player == NULL) return GP_RESULT_ERROR;
+
+	return gp_tap_levels(&player->tap, frames_size, levels);
+}
+
+enum GpResult gp_player_get_spectrum(struct GpPlayer* player, float* magnitudes, size_t magnitudes_size) {
+	if (player == NULL) return GP_RESULT_ERROR;
+
+	return gp_tap_spectrum(&player->tap, magnitudes, magnitudes_size);
+}
+
+enum GpResult gp_player_add_zone(struct GpPlayer* player, int device) {
+	if (player == NULL || !player->zoned) return GP_RESULT_ERROR;
+
+	size_t queued_zones_size = player->queued_zones_size;
+	do {
+		if (queued_zones_size >= GP_MAX_ZONES) return GP_RESULT_ERROR;
+	} while (!atomic_compare_exchange_weak(&player->queued_zones_size, &queued_zones_size, queued_zones_size + 1));
+
+	struct GpZone* zone = gp_zone_open(player->mixer_stream_handle, device);
+	if (zone == NULL) {
+		atomic_fetch_sub(&player->queued_zones_size, 1);
+		return GP_RESULT_ERROR;
+	}
+
+	return post_command(player, (struct GpCommand){.type = GP_COMMAND_ADD_ZONE, .zone = zone});
+}
+
+enum GpResult gp_player_remove_zone(struct GpPlayer* player, size_t index) {
+	if (player == NULL) return GP_RESULT_ERROR;
+
+	size_t queued_zones_size = player->queued_zones_size;
+	do {
+		if (index >= queued_zones_size) return GP_RESULT_ERROR;
+	} while (!atomic_compare_exchange_weak(&player->queued_zones_size, &queued_zones_size, queued_zones_size - 1));
+
+	return post_command(player, (struct GpCommand){.type = GP_COMMAND_REMOVE_ZONE, .zone_index = index});
+}
+
+enum GpResult gp_player_set_zone_gain(struct GpPlayer* player, size_t index, float gain) {
+	if (player == NULL || index >= player->queued_zones_size) return GP_RESULT_ERROR;
+
+	return post_command(player, (struct GpCommand){
+			.type = GP_COMMAND_SET_ZONE_GAIN,
+			.zone_gain = {index, gain}
+	});
+}
+
+enum GpResult gp_player_set_zone_latency_offset(struct GpPlayer* player, size_t index, uint32_t milliseconds) {
+	if (player == NULL || index >= player->queued_zones_size) return GP_RESULT_ERROR;
+
+	return post_command(player, (struct GpCommand){
+			.type = GP_COMMAND_SET_ZONE_LATENCY_OFFSET,
+			.zone_latency_offset = {index, milliseconds}
+	});
+}
+
+size_t gp_player_get_zones_size(struct GpPlayer* player) {
+	if (player == NULL) return 0;
+
+	return player->queued_zones_size;
+}
+
+enum GpResult gp_player_open_sink(struct GpPlayer* player, const char* path, enum GpSinkFormat format) {
+	if (player == NULL || !player->sink_output || player->sink != NULL) return GP_RESULT_ERROR;
+
+	struct GpSink* sink = gp_sink_open(path, format, player->mixer_stream_handle, player->sample_rate,
+			&player->output_playback_state);
+	if (sink == NULL) return GP_RESULT_ERROR;
+
+	struct GpSink* expected = NULL;
+	if (!atomic_compare_exchange_strong(&player->sink, &expected, sink)) {
+		gp_sink_close(sink);
+		return GP_RESULT_ERROR;
+	}
+
+	return GP_RESULT_OK;
+}
+
+enum GpResult gp_player_get_sink_stats(struct GpPlayer* player, struct GpSinkStats* stats) {
+	if (player == NULL || stats == NULL) return GP_RESULT_ERROR;
+
+	struct GpSink* sink = player->sink;
+	if (sink == NULL) return GP_RESULT_ERROR;
+
+	gp_sink_get_stats(sink, stats);
+
+	return GP_RESULT_OK;
+}
+
+bool gp_player_poll_event(struct GpPlayer* player, struct GpEvent* event) {
+	if (player == NULL || event == NULL) return false;
+
+	return gp_event_queue_pop(&player->events, event);
+}
+
+int gp_player_get_event_fd(struct GpPlayer* player) {
+	if (player == NULL) return -1;
+
+	return player->events.fd;
+}
+
+void gp_player_set_position_interval(struct GpPlayer* player, double seconds) {
+	if (player == NULL) return;
+
+	player->position_interval = seconds > 0 ? seconds : 0;
+}
+
+size_t gp_player_render(struct GpPlayer* player, float* buffer, size_t frames_size) {
+	if (player == NULL || !player->render) return 0;
+
+	gp_player_flush(player);
+
+	if (player->stream_handle == 0) return 0;
+
+	size_t frame_bytes = GP_MIXER_CHANNELS * sizeof(float);
+	size_t rendered_bytes = 0;
+	size_t requested_bytes = frames_size * frame_bytes;
+
+	while (rendered_bytes < requested_bytes) {
+		uint32_t read_bytes = BASS_ChannelGetData(player->mixer_stream_handle,
+				(uint8_t*)buffer + rendered_bytes,
+				(uint32_t)(requested_bytes - rendered_bytes) | BASS_DATA_FLOAT);
+
+		if (read_bytes == (uint32_t)-1 || read_bytes == 0) {
+			if (!player->advance_pending) break;
+
+			mtx_lock(&player->owner_mutex);
+			while (player->advance_pending) cnd_wait(&player->applied_condition, &player->owner_mutex);
+			mtx_unlock(&player->owner_mutex);
+			continue;
+		}
+		rendered_bytes += read_bytes;
+	}
+
+	BASS_ChannelLock(player->mixer_stream_handle, TRUE);
+	publish_snapshot(player);
+	BASS_ChannelLock(player->mixer_stream_handle, FALSE);
+
+	return rendered_bytes / frame_bytes;
+}
+
+enum GpResult gp_player_render_to_file(struct GpPlayer* player, const char* path) {
+	if (player == NULL || !player->render) return GP_RESULT_ERROR;
+
+	gp_player_flush(player);
+
+	if (player->sources_size == 0) return GP_RESULT_ERROR;
+
+	if (player->stream_handle == 0) {
+		gp_player_play(player);
+		gp_player_flush(player);
+	}
+
+	struct GpWavWriter writer;
+	if (gp_wav_open(&writer, path, player->sample_rate, GP_MIXER_CHANNELS) != GP_RESULT_OK) {
+		return GP_RESULT_ERROR;
+	}
+
+	float buffer[GP_RENDER_BLOCK_FRAMES * GP_MIXER_CHANNELS];
+	size_t frames_size;
+	enum GpResult result = GP_RESULT_OK;
+
+	while ((frames_size = gp_player_render(player, buffer, GP_RENDER_BLOCK_FRAMES)) > 0) {
+		if (gp_wav_write(&writer, buffer, frames_size) != GP_RESULT_OK) {
+			result = GP_RESULT_ERROR;
+			break;
+		}
 	}
 
-	player->source_index++;
-	load_stream();
+	if (gp_wav_close(&writer) != GP_RESULT_OK) return GP_RESULT_ERROR;
+
+	return result;
+}
+
+enum GpResult gp_init_ex(const struct GpInitOptions* options) {
+	if (default_player != NULL) return GP_RESULT_ERROR;
+
+	default_player = gp_player_create(options);
+
+	return default_player != NULL ? GP_RESULT_OK : GP_RESULT_ERROR;
+}
+
+enum GpResult gp_init(enum GpSampleRate sample_rate) {
+	struct GpInitOptions options = {sample_rate, GP_OUTPUT_MODE_DEVICE, GP_LATENCY_PROFILE_BALANCED};
+	return gp_init_ex(&options);
+}
+
+enum GpResult gp_init_render(enum GpSampleRate sample_rate) {
+	struct GpInitOptions options = {sample_rate, GP_OUTPUT_MODE_RENDER, GP_LATENCY_PROFILE_BALANCED};
+	return gp_init_ex(&options);
+}
+
+enum GpResult gp_close(void) {
+	struct GpPlayer* player = default_player;
+	default_player = NULL;
+
+	return gp_player_destroy(player);
+}
+
+enum GpResult gp_set_plugin_path(const char* path) {
+	return gp_plugin_set_search_path(path);
+}
+
+void gp_flush(void) {
+	gp_player_flush(default_player);
+}
+
+enum GpResult gp_set_sources(const char** sources, size_t sources_size) {
+	return gp_player_set_sources(default_player, sources, sources_size);
+}
+
+enum GpResult gp_insert_sources(size_t index, const char** sources, size_t sources_size) {
+	return gp_player_insert_sources(default_player, index, sources, sources_size);
+}
+
+enum GpResult gp_append_sources(const char** sources, size_t sources_size) {
+	return gp_player_append_sources(default_player, sources, sources_size);
+}
+
+enum GpResult gp_remove_sources(size_t index, size_t sources_size) {
+	return gp_player_remove_sources(default_player, index, sources_size);
+}
+
+enum GpResult gp_move_source(size_t from_index, size_t to_index) {
+	return gp_player_move_source(default_player, from_index, to_index);
+}
+
+enum GpPlaybackState gp_get_playback_state(void) {
+	return gp_player_get_playback_state(default_player);
+}
+
+size_t gp_get_sources_size(void) {
+	return gp_player_get_sources_size(default_player);
+}
+
+size_t gp_get_source_index(void) {
+	return gp_player_get_source_index(default_player);
+}
+
+static void create_source_path_key(void) {
+	source_path_key_created = tss_create(&source_path_key, free) == thrd_success;
+}
+
+const char* gp_get_source_path(void) {
+	call_once(&source_path_once, create_source_path_key);
+	if (!source_path_key_created) return NULL;
+
+	struct GpSourcePath* source_path = tss_get(source_path_key);
+	size_t capacity = source_path == NULL ? 0 : source_path->capacity;
+	size_t path_size;
+
+	while ((path_size = gp_player_get_source_path(default_player, source_path == NULL ? NULL : source_path->path,
+			capacity)) >= capacity && path_size > 0) {
+		struct GpSourcePath* grown_source_path = realloc(source_path, sizeof(struct GpSourcePath) + path_size + 1);
+		if (grown_source_path == NULL) return NULL;
+
+		source_path = grown_source_path;
+		source_path->capacity = capacity = path_size + 1;
+		tss_set(source_path_key, source_path);
+	}
+
+	return path_size == 0 ? NULL : source_path->path;
+}
+
+double gp_get_source_position(void) {
+	return gp_player_get_source_position(default_player);
+}
+
+uint64_t gp_get_source_position_frames(void) {
+	return gp_player_get_source_position_frames(default_player);
+}
+
+double gp_get_source_duration(void) {
+	return gp_player_get_source_duration(default_player);
+}
+
+float gp_get_volume(void) {
+	return gp_player_get_volume(default_player);
+}
+
+void gp_set_volume(float volume) {
+	gp_player_set_volume(default_player, volume);
+}
+
+void gp_set_replay_gain_mode(enum GpReplayGainMode replay_gain_mode) {
+	gp_player_set_replay_gain_mode(default_player, replay_gain_mode);
+}
+
+void gp_set_source_mode(enum GpSourceMode source_mode) {
+	gp_player_set_source_mode(default_player, source_mode);
+}
+
+void gp_set_crossfade(double seconds) {
+	gp_player_set_crossfade(default_player, seconds);
+}
+
+enum GpResult gp_get_init_stats(struct GpInitStats* stats) {
+	return gp_player_get_init_stats(default_player, stats);
+}
+
+enum GpResult gp_get_handover_stats(struct GpHandoverStats* stats) {
+	return gp_player_get_handover_stats(default_player, stats);
+}
+
+enum GpResult gp_get_snapshot(struct GpSnapshot* snapshot) {
+	return gp_player_get_snapshot(default_player, snapshot);
+}
+
+enum GpResult gp_get_output_config(struct GpOutputConfig* config) {
+	return gp_player_get_output_config(default_player, config);
+}
+
+enum GpResult gp_get_source_info(size_t index, struct GpSourceInfo* info) {
+	return gp_player_get_source_info(default_player, index, info);
+}
+
+enum GpResult gp_open_metadata_cache(const char* path) {
+	return gp_player_open_metadata_cache(default_player, path);
+}
+
+enum GpResult gp_save_metadata_cache(void) {
+	return gp_player_save_metadata_cache(default_player);
+}
+
+enum GpResult gp_scan(const char** paths, size_t paths_size, size_t threads_size, GpScanCallback callback,
+		void* user) {
+	return gp_player_scan(default_player, paths, paths_size, threads_size, callback, user);
+}
+
+enum GpResult gp_get_source_loudness(size_t index, struct GpLoudnessInfo* loudness) {
+	return gp_player_get_source_loudness(default_player, index, loudness);
+}
+
+enum GpResult gp_analyze(const char** paths, size_t paths_size, size_t threads_size, GpAnalysisCallback callback,
+		void* user) {
+	return gp_player_analyze(default_player, paths, paths_size, threads_size, callback, user);
+}
+
+enum GpResult gp_get_pcm(float* frames, size_t frames_size) {
+	return gp_player_get_pcm(default_player, frames, frames_size);
+}
+
+enum GpResult gp_get_levels(size_t frames_size, struct GpLevels* levels) {
+	return gp_player_get_levels(default_player, frames_size, levels);
+}
+
+enum GpResult gp_get_spectrum(float* magnitudes, size_t magnitudes_size) {
+	return gp_player_get_spectrum(default_player, magnitudes, magnitudes_size);
+}
+
+enum GpResult gp_add_zone(int device) {
+	return gp_player_add_zone(default_player, device);
+}
+
+enum GpResult gp_remove_zone(size_t index) {
+	return gp_player_remove_zone(default_player, index);
+}
+
+enum GpResult gp_set_zone_gain(size_t index, float gain) {
+	return gp_player_set_zone_gain(default_player, index, gain);
+}
+
+enum GpResult gp_set_zone_latency_offset(size_t index, uint32_t milliseconds) {
+	return gp_player_set_zone_latency_offset(default_player, index, milliseconds);
+}
+
+size_t gp_get_zones_size(void) {
+	return gp_player_get_zones_size(default_player);
+}
+
+enum GpResult gp_open_sink(const char* path, enum GpSinkFormat format) {
+	return gp_player_open_sink(default_player, path, format);
+}
+
+enum GpResult gp_get_sink_stats(struct GpSinkStats* stats) {
+	return gp_player_get_sink_stats(default_player, stats);
+}
+
+bool gp_poll_event(struct GpEvent* event) {
+	return gp_player_poll_event(default_player, event);
+}
+
+int gp_get_event_fd(void) {
+	return gp_player_get_event_fd(default_player);
+}
+
+void gp_set_position_interval(double seconds) {
+	gp_player_set_position_interval(default_player, seconds);
+}
+
+void gp_play(void) {
+	gp_player_play(default_player);
+}
+
+void gp_stop(void) {
+	gp_player_stop(default_player);
+}
+
+void gp_pause(void) {
+	gp_player_pause(default_player);
+}
+
+void gp_seek(double seconds) {
+	gp_player_seek(default_player, seconds);
+}
+
+void gp_skip_to(size_t source_index) {
+	gp_player_skip_to(default_player, source_index);
+}
+
+size_t gp_render(float* buffer, size_t frames_size) {
+	return gp_player_render(default_player, buffer, frames_size);
+}
+
+enum GpResult gp_render_to_file(const char* path) {
+	return gp_player_render_to_file(default_player, path);
+}
+
+int run_owner_thread(void* arg) {
+	struct GpPlayer* player = arg;
+	struct GpCommand command;
+
+	while (true) {
+		bool applied = false;
+
+		while (gp_ring_pop(&player->commands, &command)) {
+			if (command.type == GP_COMMAND_QUIT) {
+				player->applied_commands++;
+				return 0;
+			}
+
+			apply_command(player, &command);
+
+			BASS_ChannelLock(player->mixer_stream_handle, TRUE);
+			publish_snapshot(player);
+			BASS_ChannelLock(player->mixer_stream_handle, FALSE);
+
+			player->applied_commands++;
+			applied = true;
+		}
+
+		unsigned requests = atomic_exchange_explicit(&player->requests, 0, memory_order_acquire);
+		if (requests != 0) {
+			if ((requests & GP_REQUEST_ADVANCE) != 0) {
+				apply_advance(player);
+				player->advance_pending = false;
+			}
+			if ((requests & GP_REQUEST_PRELOAD) != 0) apply_preload(player);
+
+			BASS_ChannelLock(player->mixer_stream_handle, TRUE);
+			publish_snapshot(player);
+			BASS_ChannelLock(player->mixer_stream_handle, FALSE);
+			applied = true;
+		}
+
+		mtx_lock(&player->owner_mutex);
+		if (applied) {
+			cnd_broadcast(&player->applied_condition);
+		} else if (player->applied_commands == player->posted_commands && player->requests == 0) {
+			cnd_wait(&player->owner_condition, &player->owner_mutex);
+		}
+		mtx_unlock(&player->owner_mutex);
+	}
+}
+
+enum GpResult post_command(struct GpPlayer* player, struct GpCommand command) {
+	if (player == NULL) return GP_RESULT_ERROR;
+
+	player->posted_commands++;
+	while (!gp_ring_push(&player->commands, &command)) {
+		thrd_yield();
+	}
+
+	mtx_lock(&player->owner_mutex);
+	cnd_signal(&player->owner_condition);
+	mtx_unlock(&player->owner_mutex);
+
+	return GP_RESULT_OK;
+}
+
+void post_request(struct GpPlayer* player, enum GpRequest request) {
+	atomic_fetch_or_explicit(&player->requests, (unsigned)request, memory_order_release);
+
+	mtx_lock(&player->owner_mutex);
+	cnd_signal(&player->owner_condition);
+	mtx_unlock(&player->owner_mutex);
+}
+
+enum GpResult reserve_queued_sources(struct GpPlayer* player, size_t index, size_t inserted_size,
+		size_t removed_size) {
+	size_t queued_sources_size = player->queued_sources_size;
+
+	do {
+		if (index != SIZE_MAX
+				&& (index > queued_sources_size || removed_size > queued_sources_size - index)) {
+			return GP_RESULT_ERROR;
+		}
+	} while (!atomic_compare_exchange_weak(&player->queued_sources_size, &queued_sources_size,
+			queued_sources_size + inserted_size - removed_size));
+
+	return GP_RESULT_OK;
+}
+
+void release_queued_sources(struct GpPlayer* player, size_t inserted_size, size_t removed_size) {
+	atomic_fetch_add(&player->queued_sources_size, removed_size - inserted_size);
+}
+
+void apply_set_sources(struct GpPlayer* player, struct GpSourceList* sources) {
+	uint32_t stream_handle = player->stream_handle;
+	if (stream_handle != 0) BASS_Mixer_ChannelRemove(stream_handle);
+
+	discard_next_stream(player);
+
+	BASS_ChannelLock(player->mixer_stream_handle, TRUE);
+	remove_fading_stream(player);
+	mtx_lock(&player->sources_mutex);
+	struct GpSourceList* previous_sources = player->sources;
+	player->sources = sources;
+	mtx_unlock(&player->sources_mutex);
+
+	player->sources_size = sources->size;
+	player->source_index = 0;
+	player->current_removed = false;
+	player->stream_handle = 0;
+	BASS_ChannelLock(player->mixer_stream_handle, FALSE);
+
+	gp_free_source_list(previous_sources);
+}
+
+void apply_insert_sources(struct GpPlayer* player, size_t index, struct GpSourceList* sources) {
+	if (player->sources == NULL) {
+		if (index == 0 || index == SIZE_MAX) {
+			apply_set_sources(player, sources);
+		} else {
+			release_queued_sources(player, sources->size, 0);
+			gp_free_source_list(sources);
+		}
+		return;
+	}
+
+	BASS_ChannelLock(player->mixer_stream_handle, TRUE);
+	mtx_lock(&player->sources_mutex);
+	if (index == SIZE_MAX) index = player->sources->size;
+	enum GpResult result = gp_source_list_insert_list(player->sources, index, sources);
+	mtx_unlock(&player->sources_mutex);
+
+	if (result == GP_RESULT_OK) player->sources_size = player->sources->size;
+
+	if (result == GP_RESULT_OK && player->stream_handle != 0) {
+		if (index < player->source_index || (index == player->source_index && !player->current_removed)) {
+			player->source_index += sources->size;
+		}
+		if (index <= player->next_source_index) player->next_source_index += sources->size;
+		player->lookahead_generation++;
+	}
+	BASS_ChannelLock(player->mixer_stream_handle, FALSE);
+
+	if (result == GP_RESULT_OK) update_next_stream(player);
+	else release_queued_sources(player, sources->size, 0);
+
+	gp_free_source_list(sources);
+}
+
+void apply_remove_sources(struct GpPlayer* player, size_t index, size_t sources_size) {
+	if (player->sources == NULL) {
+		release_queued_sources(player, 0, sources_size);
+		return;
+	}
+
+	BASS_ChannelLock(player->mixer_stream_handle, TRUE);
+	mtx_lock(&player->sources_mutex);
+	enum GpResult result = gp_source_list_remove(player->sources, index, sources_size);
+	mtx_unlock(&player->sources_mutex);
+
+	if (result == GP_RESULT_OK) player->sources_size = player->sources->size;
+
+	if (result == GP_RESULT_OK && player->stream_handle != 0) {
+		if (player->source_index >= index + sources_size) {
+			player->source_index -= sources_size;
+		}
+		else if (player->source_index >= index) {
+			player->source_index = index;
+			player->current_removed = true;
+		}
+
+		if (player->next_source_index >= index + sources_size) {
+			player->next_source_index -= sources_size;
+		}
+		else if (player->next_source_index >= index) {
+			player->next_source_index = SIZE_MAX;
+		}
+		player->lookahead_generation++;
+	}
+	BASS_ChannelLock(player->mixer_stream_handle, FALSE);
+
+	if (result == GP_RESULT_OK) update_next_stream(player);
+	else release_queued_sources(player, 0, sources_size);
+}
+
+size_t move_index(size_t source_index, size_t from_index, size_t to_index) {
+	if (source_index == from_index) return to_index;
+	if (from_index < source_index && source_index <= to_index) return source_index - 1;
+	if (to_index <= source_index && source_index < from_index) return source_index + 1;
+	return source_index;
+}
+
+void apply_move_source(struct GpPlayer* player, size_t from_index, size_t to_index) {
+	if (player->sources == NULL) return;
+
+	BASS_ChannelLock(player->mixer_stream_handle, TRUE);
+	mtx_lock(&player->sources_mutex);
+	enum GpResult result = gp_source_list_move(player->sources, from_index, to_index);
+	mtx_unlock(&player->sources_mutex);
+
+	if (result == GP_RESULT_OK && player->stream_handle != 0) {
+		if (!player->current_removed) {
+			player->source_index = move_index(player->source_index, from_index, to_index);
+		}
+		else if (from_index < player->source_index && to_index >= player->source_index) {
+			player->source_index--;
+		}
+		else if (from_index >= player->source_index && to_index < player->source_index) {
+			player->source_index++;
+		}
+
+		player->next_source_index = move_index(player->next_source_index, from_index, to_index);
+		player->lookahead_generation++;
+	}
+	BASS_ChannelLock(player->mixer_stream_handle, FALSE);
+
+	if (result == GP_RESULT_OK) update_next_stream(player);
+}
+
+void apply_play(struct GpPlayer* player) {
+	if (player->sources == NULL) return;
+
+	if (player->stream_handle == 0) {
+		load_stream(player, player->source_index);
+	}
+
+	if (player->render) return;
+
+	play_output(player);
+}
+
+void apply_stop(struct GpPlayer* player) {
+	stop_output(player);
+	BASS_ChannelSetPosition(player->mixer_stream_handle, 0, BASS_POS_BYTE);
+
+	BASS_ChannelLock(player->mixer_stream_handle, TRUE);
+	BASS_Mixer_ChannelRemove(player->stream_handle);
+	remove_fading_stream(player);
+	player->stream_handle = 0;
+	player->source_index = 0;
+	player->current_removed = false;
+	BASS_ChannelLock(player->mixer_stream_handle, FALSE);
+
+	discard_next_stream(player);
+}
+
+void apply_seek(struct GpPlayer* player, double seconds) {
+	uint32_t stream_handle = player->stream_handle;
+	if (stream_handle == 0) return;
+
+	uint64_t position = BASS_ChannelSeconds2Bytes(stream_handle, seconds);
+	BASS_Mixer_ChannelSetPosition(stream_handle, position,
+			BASS_POS_BYTE | BASS_MIXER_CHAN_NORAMPIN | BASS_POS_MIXER_RESET);
+	flush_zones(player);
+}
+
+void apply_skip_to(struct GpPlayer* player, size_t source_index) {
+	if (player->sources == NULL || source_index >= player->sources->size) return;
+
+	load_stream(player, source_index);
+	flush_zones(player);
+}
+
+void apply_set_volume(struct GpPlayer* player, float volume) {
+	gp_gain_stage_set_volume(&player->gain_stage, volume);
+}
+
+void apply_set_replay_gain_mode(struct GpPlayer* player, enum GpReplayGainMode replay_gain_mode) {
+	BASS_ChannelLock(player->mixer_stream_handle, TRUE);
+	player->replay_gain_mode = replay_gain_mode;
+	gp_gain_stage_set_source_gain(&player->gain_stage,
+			gp_gain_read_replay_gain(player->stream_handle, replay_gain_mode));
+	BASS_ChannelLock(player->mixer_stream_handle, FALSE);
+}
+
+void apply_set_source_mode(struct GpPlayer* player, enum GpSourceMode source_mode) {
+	BASS_ChannelLock(player->mixer_stream_handle, TRUE);
+	player->source_mode = source_mode;
+	BASS_ChannelLock(player->mixer_stream_handle, FALSE);
+}
+
+void apply_set_crossfade(struct GpPlayer* player, double seconds) {
+	BASS_ChannelLock(player->mixer_stream_handle, TRUE);
+	player->crossfade_seconds = seconds;
+	set_crossfade_sync(player);
+	BASS_ChannelLock(player->mixer_stream_handle, FALSE);
+
+	update_next_stream(player);
+}
+
+uint32_t create_stream(struct GpPlayer* player, const struct GpSource* source);
+
+void apply_preload(struct GpPlayer* player) {
+	BASS_ChannelLock(player->mixer_stream_handle, TRUE);
+	size_t next_source_index = get_next_source_index(player);
+	uint32_t lookahead_generation = player->lookahead_generation;
+	bool has_next = player->sources != NULL && next_source_index < player->sources->size
+			&& player->next_stream_handle == 0;
+	BASS_ChannelLock(player->mixer_stream_handle, FALSE);
+
+	if (!has_next) return;
+
+	struct GpSource next_source = gp_source_list_get(player->sources, next_source_index);
+	uint32_t next_stream_handle = create_stream(player, &next_source);
+
+	if (next_stream_handle == 0) {
+		push_event(player, GP_EVENT_TYPE_STREAM_OPEN_FAILED, next_source_index, 0);
+		return;
+	}
+
+	BASS_ChannelLock(player->mixer_stream_handle, TRUE);
+	bool is_current = lookahead_generation == player->lookahead_generation;
+	if (is_current) {
+		player->next_source_index = next_source_index;
+		player->next_stream_handle = next_stream_handle;
+	}
+	BASS_ChannelLock(player->mixer_stream_handle, FALSE);
+
+	if (!is_current) BASS_StreamFree(next_stream_handle);
+}
+
+void apply_advance(struct GpPlayer* player) {
+	if (player->stream_handle != player->advance_stream_handle) return;
+
+	size_t next_source_index = get_next_source_index(player);
+	if (player->sources == NULL || next_source_index >= player->sources->size) return;
+
+	bool preloaded = player->next_stream_handle != 0 && player->next_source_index == next_source_index;
+	load_stream(player, next_source_index);
+	if (!player->render) play_output(player);
+
+	publish_handover_stats(player, player->advance_time, preloaded);
+}
+
+void apply_add_zone(struct GpPlayer* player, struct GpZone* zone) {
+	BASS_ChannelLock(player->mixer_stream_handle, TRUE);
+	player->zones[player->zones_size++] = zone;
+	BASS_ChannelLock(player->mixer_stream_handle, FALSE);
+
+	if (player->output_playback_state == GP_PLAYBACK_STATE_PLAYING) gp_zone_play(zone);
+}
+
+void apply_remove_zone(struct GpPlayer* player, size_t index) {
+	if (index >= player->zones_size) return;
+
+	BASS_ChannelLock(player->mixer_stream_handle, TRUE);
+	struct GpZone* zone = player->zones[index];
+	memmove(&player->zones[index], &player->zones[index + 1],
+			(player->zones_size - index - 1) * sizeof(struct GpZone*));
+	player->zones_size--;
+	BASS_ChannelLock(player->mixer_stream_handle, FALSE);
+
+	gp_zone_close(zone);
+}
+
+void apply_set_zone_gain(struct GpPlayer* player, size_t index, float gain) {
+	if (index >= player->zones_size) return;
+
+	gp_zone_set_gain(player->zones[index], gain);
+}
+
+void apply_set_zone_latency_offset(struct GpPlayer* player, size_t index, uint32_t milliseconds) {
+	if (index >= player->zones_size) return;
+
+	gp_zone_set_latency_offset(player->zones[index], milliseconds);
+}
+
+void apply_command(struct GpPlayer* player, const struct GpCommand* command) {
+	switch (command->type) {
+	case GP_COMMAND_SET_SOURCES: apply_set_sources(player, command->sources);
+		break;
+	case GP_COMMAND_INSERT_SOURCES: apply_insert_sources(player, command->insert.index, command->insert.sources);
+		break;
+	case GP_COMMAND_REMOVE_SOURCES: apply_remove_sources(player, command->remove.index, command->remove.size);
+		break;
+	case GP_COMMAND_MOVE_SOURCE: apply_move_source(player, command->move.from_index, command->move.to_index);
+		break;
+	case GP_COMMAND_PLAY: apply_play(player);
+		break;
+	case GP_COMMAND_STOP: apply_stop(player);
+		break;
+	case GP_COMMAND_PAUSE: pause_output(player);
+		break;
+	case GP_COMMAND_SEEK: apply_seek(player, command->seconds);
+		break;
+	case GP_COMMAND_SKIP_TO: apply_skip_to(player, command->source_index);
+		break;
+	case GP_COMMAND_SET_VOLUME: apply_set_volume(player, command->volume);
+		break;
+	case GP_COMMAND_SET_REPLAY_GAIN_MODE: apply_set_replay_gain_mode(player, command->replay_gain_mode);
+		break;
+	case GP_COMMAND_SET_SOURCE_MODE: apply_set_source_mode(player, command->source_mode);
+		break;
+	case GP_COMMAND_SET_CROSSFADE: apply_set_crossfade(player, command->seconds);
+		break;
+	case GP_COMMAND_ADD_ZONE: apply_add_zone(player, command->zone);
+		break;
+	case GP_COMMAND_REMOVE_ZONE: apply_remove_zone(player, command->zone_index);
+		break;
+	case GP_COMMAND_SET_ZONE_GAIN: apply_set_zone_gain(player, command->zone_gain.index, command->zone_gain.gain);
+		break;
+	case GP_COMMAND_SET_ZONE_LATENCY_OFFSET:
+		apply_set_zone_latency_offset(player, command->zone_latency_offset.index,
+				command->zone_latency_offset.milliseconds);
+		break;
+	case GP_COMMAND_QUIT: break;
+	}
+}
+
+uint32_t create_stream(struct GpPlayer* player, const struct GpSource* source) {
+	bool mapped = player->source_mode == GP_SOURCE_MODE_MAPPED;
+
+	struct GpFileMap* file_map = gp_file_map_open(source, GP_FILE_MAP_ACCESS_SEQUENTIAL);
+	if (file_map == NULL && mapped) return 0;
+
+	if (file_map != NULL) {
+		struct GpSeekIndex* index = gp_seek_index_open(player->metadata_cache, source, file_map);
+		if (index != NULL) return gp_seek_index_create_stream(index, BASS_STREAM_DECODE | BASS_SAMPLE_FLOAT);
+
+		if (mapped) return gp_file_map_create_stream(file_map, BASS_STREAM_DECODE | BASS_SAMPLE_FLOAT);
+		gp_file_map_close(file_map);
+	}
+
+	return gp_source_create_stream(source, BASS_STREAM_DECODE | BASS_SAMPLE_FLOAT | BASS_ASYNCFILE);
+}
+
+uint32_t create_mixer_stream(struct GpPlayer* player, uint32_t sample_rate, struct GpInitStats* stats) {
+	uint32_t mixer_flags = player->render || player->decode_output ? BASS_MIXER_END | BASS_STREAM_DECODE : BASS_MIXER_END;
+	gp_audio_output_select_device(player->render || player->decode_output);
+	double create_start = gp_clock_now();
+	uint32_t mixer_stream_handle = BASS_Mixer_StreamCreate(sample_rate, GP_MIXER_CHANNELS,
+			mixer_flags | BASS_MIXER_POSEX | BASS_SAMPLE_FLOAT);
+	if (mixer_stream_handle == 0) return 0;
+
+	double sync_start = gp_clock_now();
+	uint32_t set_sync_result = BASS_ChannelSetSync(mixer_stream_handle,
+			BASS_SYNC_END | BASS_SYNC_MIXTIME, 0,
+			&handle_track_end_sync, player);
+
+	if (stats != NULL) {
+		stats->mixer_create_seconds = sync_start - create_start;
+		stats->sync_setup_seconds = gp_clock_now() - sync_start;
+	}
+
+	if (set_sync_result == 0
+			|| BASS_ChannelSetDSP(mixer_stream_handle, &handle_mixer_dsp, player, 0) == 0) {
+		BASS_StreamFree(mixer_stream_handle);
+		return 0;
+	}
+
+	return mixer_stream_handle;
+}
+
+bool matches_mixer_rate(struct GpPlayer* player, uint32_t stream_handle) {
+	if (!player->native_rate) return true;
+
+	BASS_CHANNELINFO info;
+	return !BASS_ChannelGetInfo(stream_handle, &info) || info.freq == player->sample_rate;
+}
+
+bool set_mixer_rate(struct GpPlayer* player, uint32_t sample_rate) {
+	uint32_t previous_mixer_stream_handle = player->mixer_stream_handle;
+	bool playing = BASS_ChannelIsActive(previous_mixer_stream_handle) == BASS_ACTIVE_PLAYING;
+
+	BASS_ChannelStop(previous_mixer_stream_handle);
+	if (gp_audio_output_set_sample_rate(sample_rate) != GP_RESULT_OK) return playing;
+
+	uint32_t mixer_stream_handle = create_mixer_stream(player, sample_rate, NULL);
+	if (mixer_stream_handle == 0) return playing;
+
+	BASS_ChannelLock(previous_mixer_stream_handle, TRUE);
+	if (player->stream_handle != 0) BASS_Mixer_ChannelRemove(player->stream_handle);
+	remove_fading_stream(player);
+	player->mixer_stream_handle = mixer_stream_handle;
+	player->sample_rate = sample_rate;
+	gp_gain_stage_set_sample_rate(&player->gain_stage, sample_rate);
+	player->stream_handle = 0;
+	BASS_ChannelLock(previous_mixer_stream_handle, FALSE);
+
+	BASS_StreamFree(previous_mixer_stream_handle);
+
+	return playing;
+}
+
+uint32_t take_next_stream(struct GpPlayer* player, size_t source_index) {
+	BASS_ChannelLock(player->mixer_stream_handle, TRUE);
+	uint32_t next_stream_handle = 0;
+	if (player->next_source_index == source_index) {
+		next_stream_handle = player->next_stream_handle;
+		player->next_stream_handle = 0;
+	}
+	BASS_ChannelLock(player->mixer_stream_handle, FALSE);
+
+	if (next_stream_handle == 0) discard_next_stream(player);
+
+	return next_stream_handle;
+}
+
+void load_stream(struct GpPlayer* player, size_t source_index) {
+	if (player->sources == NULL || source_index >= player->sources->size) return;
+
+	uint32_t stream_handle = take_next_stream(player, source_index);
+
+	if (stream_handle == 0) {
+		struct GpSource source = gp_source_list_get(player->sources, source_index);
+		stream_handle = create_stream(player, &source);
+	}
+
+	if (stream_handle == 0) push_event(player, GP_EVENT_TYPE_STREAM_OPEN_FAILED, source_index, 0);
+
+	bool restart = false;
+	if (stream_handle != 0 && !matches_mixer_rate(player, stream_handle)) {
+		BASS_CHANNELINFO info;
+		BASS_ChannelGetInfo(stream_handle, &info);
+		restart = set_mixer_rate(player, info.freq);
+	}
+
+	attach_stream(player, source_index, stream_handle);
+
+	if (restart) BASS_ChannelPlay(player->mixer_stream_handle, FALSE);
+
+	set_lookahead_sync(player);
+}
+
+void attach_stream(struct GpPlayer* player, size_t source_index, uint32_t stream_handle) {
+	BASS_ChannelLock(player->mixer_stream_handle, TRUE);
+	BASS_Mixer_ChannelRemove(player->stream_handle);
+	remove_fading_stream(player);
+
+	player->stream_handle = stream_handle;
+	player->source_index = source_index;
+	player->current_removed = false;
+	player->position_sync = 0;
+	player->crossfade_sync = 0;
+
+	if (stream_handle != 0) {
+		BASS_Mixer_StreamAddChannel(player->mixer_stream_handle, stream_handle,
+				BASS_MIXER_NORAMPIN | BASS_STREAM_AUTOFREE);
+		set_stream_syncs(player, stream_handle);
+		set_crossfade_sync(player);
+		gp_gain_stage_set_source_gain(&player->gain_stage,
+				gp_gain_read_replay_gain(stream_handle, player->replay_gain_mode));
+		push_event(player, GP_EVENT_TYPE_TRACK_CHANGED, source_index, 0);
+	}
+
+	BASS_ChannelSetPosition(player->mixer_stream_handle, 0, BASS_POS_BYTE);
+	BASS_ChannelLock(player->mixer_stream_handle, FALSE);
+}
+
+size_t get_next_source_index(struct GpPlayer* player) {
+	return player->current_removed ? player->source_index : player->source_index + 1;
+}
+
+void discard_next_stream(struct GpPlayer* player) {
+	BASS_ChannelLock(player->mixer_stream_handle, TRUE);
+	uint32_t next_stream_handle = player->next_stream_handle;
+	player->next_stream_handle = 0;
+	player->lookahead_generation++;
+	BASS_ChannelLock(player->mixer_stream_handle, FALSE);
+
+	if (next_stream_handle != 0) BASS_StreamFree(next_stream_handle);
+}
+
+void update_next_stream(struct GpPlayer* player) {
+	BASS_ChannelLock(player->mixer_stream_handle, TRUE);
+	bool is_stale = player->next_stream_handle != 0
+			&& player->next_source_index != get_next_source_index(player);
+	BASS_ChannelLock(player->mixer_stream_handle, FALSE);
+
+	if (is_stale) discard_next_stream(player);
+
+	if (player->next_stream_handle == 0) set_lookahead_sync(player);
+}
+
+void set_lookahead_sync(struct GpPlayer* player) {
+	uint32_t stream_handle = player->stream_handle;
+	if (stream_handle == 0) return;
+
+	uint64_t length = BASS_ChannelGetLength(stream_handle, BASS_POS_BYTE);
+	uint64_t lookahead = BASS_ChannelSeconds2Bytes(stream_handle,
+			GP_LOOKAHEAD_SECONDS + player->crossfade_seconds);
+	uint64_t position = length > lookahead ? length - lookahead : 0;
+	uint64_t current_position = BASS_Mixer_ChannelGetPosition(stream_handle, BASS_POS_BYTE);
+	if (current_position != (uint64_t)-1 && current_position > position) position = current_position;
+
+	BASS_Mixer_ChannelSetSync(stream_handle,
+			BASS_SYNC_POS | BASS_SYNC_MIXTIME | BASS_SYNC_THREAD | BASS_SYNC_ONETIME, position,
+			&handle_lookahead_sync, player);
+}
+
+void CALLBACK handle_lookahead_sync(HSYNC sync, DWORD channel, DWORD data, void* user) {
+	(void)sync;
+	(void)channel;
+	(void)data;
+
+	struct GpPlayer* player = user;
+	post_request(player, GP_REQUEST_PRELOAD);
+}
+
+void CALLBACK handle_track_end_sync(HSYNC sync, DWORD channel, DWORD data, void* user) {
+	(void)sync;
+	(void)channel;
+	(void)data;
+
+	struct GpPlayer* player = user;
+	size_t next_source_index = get_next_source_index(player);
+
+	if (player->sources == NULL || next_source_index >= player->sources->size) {
+		player->source_index = 0;
+		player->current_removed = false;
+		player->stream_handle = 0;
+		publish_snapshot(player);
+		push_event(player, GP_EVENT_TYPE_QUEUE_ENDED, 0, 0);
+		return;
+	}
+
+	double handover_start = gp_clock_now();
+	uint32_t next_stream_handle = player->next_source_index == next_source_index ? player->next_stream_handle : 0;
+
+	if (next_stream_handle == 0 || !matches_mixer_rate(player, next_stream_handle)) {
+		player->advance_stream_handle = player->stream_handle;
+		player->advance_time = handover_start;
+		player->advance_pending = true;
+		post_request(player, GP_REQUEST_ADVANCE);
+		return;
+	}
+
+	player->next_stream_handle = 0;
+	attach_stream(player, next_source_index, next_stream_handle);
+	set_lookahead_sync(player);
+
+	publish_handover_stats(player, handover_start, true);
+	publish_snapshot(player);
+}
+
+void publish_handover_stats(struct GpPlayer* player, double handover_start, bool preloaded) {
+	double handover_time = gp_clock_now() - handover_start;
+	unsigned sequence = atomic_load_explicit(&player->handover_sequence, memory_order_relaxed);
+	atomic_store_explicit(&player->handover_sequence, sequence + 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+	atomic_store_explicit(&player->handover_nanoseconds, (uint64_t)(handover_time * 1e9),
+			memory_order_relaxed);
+	atomic_store_explicit(&player->handover_preloaded, preloaded, memory_order_relaxed);
+	atomic_store_explicit(&player->handover_sequence, sequence + 2, memory_order_release);
+}
+
+void publish_snapshot(struct GpPlayer* player) {
+	uint32_t stream_handle = player->stream_handle;
+	enum GpPlaybackState playback_state = GP_PLAYBACK_STATE_STOPPED;
+	double position = 0;
+	double duration = 0;
+	float volume = atomic_load_explicit(&player->gain_stage.volume, memory_order_relaxed);
+
+	if (stream_handle != 0) {
+		playback_state = get_playback_state(player);
+		position = BASS_ChannelBytes2Seconds(stream_handle, get_audible_position(player, stream_handle));
+		duration = BASS_ChannelBytes2Seconds(stream_handle,
+				BASS_ChannelGetLength(stream_handle, BASS_POS_BYTE));
+	}
+
+	unsigned sequence = atomic_load_explicit(&player->snapshot_sequence, memory_order_relaxed);
+	atomic_store_explicit(&player->snapshot_sequence, sequence + 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+	atomic_store_explicit(&player->snapshot_playback_state, playback_state, memory_order_relaxed);
+	atomic_store_explicit(&player->snapshot_source_index, stream_handle != 0 ? player->source_index : 0,
+			memory_order_relaxed);
+	atomic_store_explicit(&player->snapshot_sources_size, player->sources_size, memory_order_relaxed);
+	atomic_store_explicit(&player->snapshot_position, position, memory_order_relaxed);
+	atomic_store_explicit(&player->snapshot_duration, duration, memory_order_relaxed);
+	atomic_store_explicit(&player->snapshot_volume, volume, memory_order_relaxed);
+	atomic_store_explicit(&player->snapshot_time, gp_clock_now(), memory_order_relaxed);
+	atomic_store_explicit(&player->snapshot_sequence, sequence + 2, memory_order_release);
+}
+
+void push_event(struct GpPlayer* player, enum GpEventType type, size_t source_index, double position) {
+	struct GpEvent event = {type, source_index, position};
+	gp_event_queue_push(&player->events, &event);
+}
+
+void CALLBACK handle_seek_sync(HSYNC sync, DWORD channel, DWORD data, void* user) {
+	(void)sync;
+	(void)data;
+
+	struct GpPlayer* player = user;
+
+	double position = BASS_ChannelBytes2Seconds(channel, BASS_ChannelGetPosition(channel, BASS_POS_BYTE));
+	set_position_sync(player, channel, position);
+	push_event(player, GP_EVENT_TYPE_SEEK_COMPLETED, player->source_index, position);
+}
+
+void CALLBACK handle_position_sync(HSYNC sync, DWORD channel, DWORD data, void* user) {
+	(void)sync;
+	(void)data;
+
+	struct GpPlayer* player = user;
+
+	double position = BASS_ChannelBytes2Seconds(channel, BASS_ChannelGetPosition(channel, BASS_POS_BYTE));
+	player->position_sync = 0;
+	set_position_sync(player, channel, position);
+	push_event(player, GP_EVENT_TYPE_POSITION, player->source_index,
+			BASS_ChannelBytes2Seconds(channel, get_audible_position(player, channel)));
+}
+
+void set_stream_syncs(struct GpPlayer* player, uint32_t stream_handle) {
+	BASS_Mixer_ChannelSetSync(stream_handle, BASS_SYNC_SETPOS | BASS_SYNC_MIXTIME, 0, &handle_seek_sync, player);
+	set_position_sync(player, stream_handle, 0);
+}
+
+void set_position_sync(struct GpPlayer* player, uint32_t stream_handle, double position) {
+	if (player->position_sync != 0) BASS_Mixer_ChannelRemoveSync(stream_handle, player->position_sync);
+	player->position_sync = 0;
+
+	double position_interval = player->position_interval;
+	if (position_interval <= 0) return;
+
+	double next_position = (double)((uint64_t)(position / position_interval) + 1) * position_interval;
+	player->position_sync = BASS_Mixer_ChannelSetSync(stream_handle,
+			BASS_SYNC_POS | BASS_SYNC_MIXTIME | BASS_SYNC_ONETIME,
+			BASS_ChannelSeconds2Bytes(stream_handle, next_position), &handle_position_sync, player);
+}
+
+void set_crossfade_sync(struct GpPlayer* player) {
+	uint32_t stream_handle = player->stream_handle;
+	if (stream_handle == 0) return;
+
+	if (player->crossfade_sync != 0) BASS_Mixer_ChannelRemoveSync(stream_handle, player->crossfade_sync);
+	player->crossfade_sync = 0;
+
+	if (player->crossfade_seconds <= 0) return;
+
+	uint64_t length = BASS_ChannelGetLength(stream_handle, BASS_POS_BYTE);
+	uint64_t fade_length = BASS_ChannelSeconds2Bytes(stream_handle, player->crossfade_seconds);
+	if (fade_length > length / 2) fade_length = length / 2;
+
+	player->crossfade_sync = BASS_Mixer_ChannelSetSync(stream_handle,
+			BASS_SYNC_POS | BASS_SYNC_MIXTIME | BASS_SYNC_ONETIME, length - fade_length,
+			&handle_crossfade_sync, player);
+}
+
+void CALLBACK handle_crossfade_sync(HSYNC sync, DWORD channel, DWORD data, void* user) {
+	(void)sync;
+	(void)data;
+
+	struct GpPlayer* player = user;
+
+	player->crossfade_sync = 0;
+
+	size_t next_source_index = get_next_source_index(player);
+	if (player->sources == NULL || next_source_index >= player->sources->size) return;
+
+	double handover_start = gp_clock_now();
+	uint32_t next_stream_handle = player->next_source_index == next_source_index ? player->next_stream_handle : 0;
+
+	if (next_stream_handle == 0 || !matches_mixer_rate(player, next_stream_handle)) {
+		push_event(player, GP_EVENT_TYPE_CROSSFADE_SKIPPED, next_source_index, 0);
+		if (next_stream_handle == 0) post_request(player, GP_REQUEST_PRELOAD);
+		return;
+	}
+	player->next_stream_handle = 0;
+
+	uint64_t remaining = BASS_ChannelGetLength(channel, BASS_POS_BYTE)
+			- BASS_Mixer_ChannelGetPosition(channel, BASS_POS_BYTE);
+	uint64_t fade_length = BASS_ChannelSeconds2Bytes(player->mixer_stream_handle,
+			BASS_ChannelBytes2Seconds(channel, remaining));
+
+	BASS_MIXER_NODE fade_out[] = {{0, 1}, {fade_length, 0}};
+	BASS_MIXER_NODE fade_in[] = {{0, 0}, {fade_length, 1}};
+
+	if (player->position_sync != 0) BASS_Mixer_ChannelRemoveSync(channel, player->position_sync);
+	player->position_sync = 0;
+	remove_fading_stream(player);
+	BASS_Mixer_ChannelSetEnvelope(channel, BASS_MIXER_ENV_VOL, fade_out, 2);
+	player->fading_stream_handle = channel;
+
+	player->stream_handle = next_stream_handle;
+	player->source_index = next_source_index;
+	player->current_removed = false;
+
+	BASS_Mixer_StreamAddChannelEx(player->mixer_stream_handle, next_stream_handle,
+			BASS_MIXER_NORAMPIN | BASS_STREAM_AUTOFREE, 0, 0);
+	BASS_Mixer_ChannelSetEnvelope(next_stream_handle, BASS_MIXER_ENV_VOL, fade_in, 2);
+	set_stream_syncs(player, next_stream_handle);
+	set_crossfade_sync(player);
+	set_lookahead_sync(player);
+	gp_gain_stage_set_source_gain(&player->gain_stage,
+			gp_gain_read_replay_gain(next_stream_handle, player->replay_gain_mode));
+	push_event(player, GP_EVENT_TYPE_TRACK_CHANGED, next_source_index, 0);
+
+	publish_handover_stats(player, handover_start, true);
+	publish_snapshot(player);
+}
+
+void CALLBACK handle_mixer_dsp(HDSP dsp, DWORD channel, void* buffer, DWORD length, void* user) {
+	(void)dsp;
+	(void)channel;
+
+	struct GpPlayer* mixer_player = user;
+	size_t frames = length / (GP_MIXER_CHANNELS * sizeof(float));
+
+	gp_gain_stage_process(&mixer_player->gain_stage, buffer, frames);
+	gp_tap_write(&mixer_player->tap, buffer, frames);
+
+	if (frames > 0 && atomic_load_explicit(&mixer_player->first_audio_pending, memory_order_relaxed)) {
+		record_first_audio(mixer_player);
+	}
+}
+
+void record_first_audio(struct GpPlayer* player) {
+	if (!atomic_exchange_explicit(&player->first_audio_pending, false, memory_order_acquire)) return;
+
+	double latency = 0;
+	if (player->zoned) {
+		if (player->zones_size > 0) latency = player->zones[0]->device_latency_ms / 1000.0;
+	} else if (!player->render && !player->decode_output) {
+		latency = gp_audio_output_get_latency_ms() / 1000.0;
+	}
+
+	double play_time = atomic_load_explicit(&player->play_time, memory_order_relaxed);
+	double first_audio_time = gp_clock_now() + latency - play_time;
+	atomic_store_explicit(&player->first_audio_nanoseconds, (uint64_t)(first_audio_time * 1e9),
+			memory_order_relaxed);
+}
+
+uint64_t get_audible_position(struct GpPlayer* player, uint32_t stream_handle) {
+	uint32_t mixer_stream_handle = player->mixer_stream_handle;
+	uint32_t delay = 0;
+
+	if (player->zoned) {
+		BASS_ChannelLock(mixer_stream_handle, TRUE);
+		struct GpZone zone = {0};
+		if (player->zones_size > 0) zone = *player->zones[0];
+		BASS_ChannelLock(mixer_stream_handle, FALSE);
+
+		if (zone.stream_handle != 0) delay = gp_zone_get_delay(&zone);
+	} else if (!player->render && !player->decode_output) {
+		uint32_t buffered = BASS_ChannelGetData(mixer_stream_handle, NULL, BASS_DATA_AVAILABLE);
+		if (buffered != (uint32_t)-1) delay = buffered;
+
+		delay += (uint32_t)BASS_ChannelSeconds2Bytes(mixer_stream_handle, gp_audio_output_get_latency_ms() / 1000.0);
+	}
+
+	uint64_t position = BASS_Mixer_ChannelGetPositionEx(stream_handle, BASS_POS_BYTE, delay);
+	if (position == (uint64_t)-1) position = BASS_ChannelGetPosition(stream_handle, BASS_POS_BYTE);
+
+	return position;
+}
+
+void remove_fading_stream(struct GpPlayer* player) {
+	if (player->fading_stream_handle != 0) BASS_Mixer_ChannelRemove(player->fading_stream_handle);
+	player->fading_stream_handle = 0;
+}
+
+void play_output(struct GpPlayer* player) {
+	if (!player->decode_output) {
+		uint32_t buffered = BASS_ChannelGetData(player->mixer_stream_handle, NULL, BASS_DATA_AVAILABLE);
+		BASS_ChannelPlay(player->mixer_stream_handle, FALSE);
+		if (buffered != (uint32_t)-1 && buffered > 0) record_first_audio(player);
+		return;
+	}
+
+	player->output_playback_state = GP_PLAYBACK_STATE_PLAYING;
+	for (size_t i = 0; i < player->zones_size; i++) gp_zone_play(player->zones[i]);
+}
+
+void pause_output(struct GpPlayer* player) {
+	if (!player->decode_output) {
+		BASS_ChannelPause(player->mixer_stream_handle);
+		return;
+	}
+
+	if (player->output_playback_state != GP_PLAYBACK_STATE_PLAYING) return;
+
+	player->output_playback_state = GP_PLAYBACK_STATE_PAUSED;
+	for (size_t i = 0; i < player->zones_size; i++) gp_zone_pause(player->zones[i]);
+}
+
+void stop_output(struct GpPlayer* player) {
+	if (!player->decode_output) {
+		BASS_ChannelStop(player->mixer_stream_handle);
+		return;
+	}
+
+	player->output_playback_state = GP_PLAYBACK_STATE_STOPPED;
+	for (size_t i = 0; i < player->zones_size; i++) gp_zone_stop(player->zones[i]);
+}
+
+void flush_zones(struct GpPlayer* player) {
+	if (player->zoned) BASS_Split_StreamReset(player->mixer_stream_handle);
 }
@@ -1,12 +1,82 @@
 #pragma once
+#include <stdatomic.h>
+#include <stdbool.h>
 #include <stdint.h>
+#include <threads.h>
 #include "grass_player.h"
+#include "gp_event.h"
+#include "gp_gain.h"
+#include "gp_metadata_cache.h"
+#include "gp_ring.h"
+#include "gp_sink.h"
 #include "gp_source_list.h"
+#include "gp_tap.h"
+#include "gp_zone.h"
+
+#define GP_LOOKAHEAD_SECONDS 5.0
+#define GP_MIXER_CHANNELS 2
+#define GP_RENDER_BLOCK_FRAMES 4096
+#define GP_POSITION_INTERVAL_SECONDS 0.25
 
 struct GpPlayer {
   struct GpSourceList* sources;
-  size_t source_index;
-  uint32_t stream_handle;
-  uint32_t mixer_stream_handle;
+  mtx_t sources_mutex;
+  atomic_size_t sources_size;
+  atomic_size_t queued_sources_size;
+  atomic_size_t source_index;
+  bool current_removed;
+  _Atomic uint32_t stream_handle;
+  _Atomic uint32_t mixer_stream_handle;
+  uint32_t sample_rate;
+  bool render;
+  bool native_rate;
+  bool zoned;
+  struct GpZone* zones[GP_MAX_ZONES];
+  size_t zones_size;
+  atomic_size_t queued_zones_size;
+  atomic_int output_playback_state;
+  bool sink_output;
+  bool decode_output;
+  struct GpSink* _Atomic sink;
+  enum GpSourceMode source_mode;
+  size_t next_source_index;
+  uint32_t next_stream_handle;
+  uint32_t lookahead_generation;
+  atomic_uint handover_sequence;
+  atomic_uint_least64_t handover_nanoseconds;
+  atomic_bool handover_preloaded;
+  struct GpInitStats init_stats;
+  _Atomic double play_time;
+  atomic_bool first_audio_pending;
+  atomic_uint_least64_t first_audio_nanoseconds;
+  atomic_uint snapshot_sequence;
+  atomic_int snapshot_playback_state;
+  atomic_size_t snapshot_source_index;
+  atomic_size_t snapshot_sources_size;
+  _Atomic double snapshot_position;
+  _Atomic double snapshot_duration;
+  _Atomic double snapshot_time;
+  _Atomic float snapshot_volume;
+  struct GpEventQueue events;
+  struct GpMetadataCache* metadata_cache;
+  _Atomic double position_interval;
+  uint32_t position_sync;
+  double crossfade_seconds;
+  uint32_t crossfade_sync;
+  uint32_t fading_stream_handle;
+  struct GpGainStage gain_stage;
+  enum GpReplayGainMode replay_gain_mode;
+  struct GpTap tap;
+  struct GpRing commands;
+  atomic_size_t posted_commands;
+  atomic_size_t applied_commands;
+  atomic_uint requests;
+  _Atomic uint32_t advance_stream_handle;
+  atomic_bool advance_pending;
+  _Atomic double advance_time;
+  mtx_t owner_mutex;
+  cnd_t owner_condition;
+  cnd_t applied_condition;
+  thrd_t owner_thread;
 };
 
@@ -0,0 +1,209 @@
+#include "gp_plugin.h"
+#include <limits.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+#include "bass.h"
+#include "gp_clock.h"
+
+static bool matches_flac(const uint8_t* data, size_t size) {
+	return size >= 4 && memcmp(data, "fLaC", 4) == 0;
+}
+
+static bool matches_ogg_flac(const uint8_t* data, size_t size) {
+	return size >= 33 && memcmp(data, "OggS", 4) == 0 && memcmp(data + 28, "\x7f" "FLAC", 5) == 0;
+}
+
+static struct GpPlugin plugins[] = {
+		{"bassflac", matches_flac, 0, false},
+		{"bassflac", matches_ogg_flac, 0, false}
+};
+
+static const size_t plugins_size = sizeof(plugins) / sizeof(plugins[0]);
+
+static char* search_path = NULL;
+static double load_seconds = 0;
+static atomic_bool plugins_settled = false;
+static mtx_t plugins_mutex;
+static once_flag plugins_once = ONCE_FLAG_INIT;
+
+static void init_plugins_mutex(void) {
+	mtx_init(&plugins_mutex, mtx_plain);
+}
+
+enum GpResult gp_plugin_set_search_path(const char* path) {
+	char* copy = NULL;
+	if (path != NULL) {
+		copy = malloc(strlen(path) + 1);
+		if (copy == NULL) return GP_RESULT_ERROR;
+		strcpy(copy, path);
+	}
+
+	call_once(&plugins_once, init_plugins_mutex);
+	mtx_lock(&plugins_mutex);
+
+	free(search_path);
+	search_path = copy;
+	for (size_t i = 0; i < plugins_size; i++) plugins[i].failed = false;
+	atomic_store(&plugins_settled, false);
+
+	mtx_unlock(&plugins_mutex);
+
+	return GP_RESULT_OK;
+}
+
+char* gp_plugin_library_path(const char* path, const char* name) {
+	if (path == NULL) path = GP_PLUGIN_DEFAULT_SEARCH_PATH;
+
+	const char* separator = path == NULL || path[0] == '\0' || path[strlen(path) - 1] == '/' ? "" : "/";
+	if (path == NULL) path = "";
+
+	size_t size = strlen(path) + strlen(separator) + strlen(GP_PLUGIN_PREFIX) + strlen(name)
+			+ strlen(GP_PLUGIN_SUFFIX) + 1;
+	char* library_path = malloc(size);
+	if (library_path == NULL) return NULL;
+
+	snprintf(library_path, size, "%s%s%s%s%s", path, separator, GP_PLUGIN_PREFIX, name, GP_PLUGIN_SUFFIX);
+
+	return library_path;
+}
+
+uint64_t gp_plugin_id3_size(const uint8_t* data, size_t size) {
+	if (size < GP_ID3_HEADER_SIZE || memcmp(data, "ID3", 3) != 0) return 0;
+
+	uint64_t tag_size = GP_ID3_HEADER_SIZE + ((uint64_t)(data[6] & 0x7f) << 21 | (uint64_t)(data[7] & 0x7f) << 14
+			| (uint64_t)(data[8] & 0x7f) << 7 | (data[9] & 0x7f));
+	if ((data[5] & 0x10) != 0) tag_size += GP_ID3_HEADER_SIZE;
+
+	return tag_size;
+}
+
+struct GpPlugin* gp_plugin_detect(const uint8_t* data, size_t size) {
+	for (size_t i = 0; i < plugins_size; i++) {
+		if (plugins[i].matches(data, size)) return &plugins[i];
+	}
+
+	return NULL;
+}
+
+static uint32_t find_loaded(const char* name) {
+	for (size_t i = 0; i < plugins_size; i++) {
+		if (plugins[i].handle != 0 && strcmp(plugins[i].name, name) == 0) return plugins[i].handle;
+	}
+
+	return 0;
+}
+
+static void load_plugin(struct GpPlugin* plugin) {
+	plugin->handle = find_loaded(plugin->name);
+	if (plugin->handle != 0) return;
+
+	char* library_path = gp_plugin_library_path(search_path, plugin->name);
+	struct GpSource* library = library_path != NULL ? gp_new_source(library_path) : NULL;
+	const GpNativeChar* native_path = library != NULL ? gp_source_native_path(library) : NULL;
+
+	if (native_path != NULL) {
+		double load_start = gp_clock_now();
+#ifdef _WIN32
+		plugin->handle = BASS_PluginLoad((const char*)native_path, BASS_UNICODE);
+#else
+		plugin->handle = BASS_PluginLoad(native_path, 0);
+#endif
+		load_seconds += gp_clock_now() - load_start;
+		gp_source_free_native_path(library, native_path);
+	}
+
+	plugin->failed = plugin->handle == 0;
+	gp_free_source(library);
+	free(library_path);
+}
+
+static bool has_pending_plugins(void) {
+	for (size_t i = 0; i < plugins_size; i++) {
+		if (plugins[i].handle == 0 && !plugins[i].failed) return true;
+	}
+
+	return false;
+}
+
+void gp_plugin_prepare(const uint8_t* data, size_t size) {
+	if (atomic_load_explicit(&plugins_settled, memory_order_acquire)) return;
+
+	uint64_t offset = gp_plugin_id3_size(data, size);
+	if (offset >= size) return;
+
+	struct GpPlugin* plugin = gp_plugin_detect(data + offset, size - (size_t)offset);
+	if (plugin == NULL) return;
+
+	call_once(&plugins_once, init_plugins_mutex);
+	mtx_lock(&plugins_mutex);
+	if (plugin->handle == 0 && !plugin->failed) load_plugin(plugin);
+	atomic_store_explicit(&plugins_settled, !has_pending_plugins(), memory_order_release);
+	mtx_unlock(&plugins_mutex);
+}
+
+static FILE* open_source(const struct GpSource* source) {
+	const GpNativeChar* native_path = gp_source_native_path(source);
+	if (native_path == NULL) return NULL;
+
+#ifdef _WIN32
+	FILE* file = _wfopen(native_path, L"rb");
+#else
+	FILE* file = fopen(native_path, "rb");
+#endif
+	gp_source_free_native_path(source, native_path);
+
+	return file;
+}
+
+void gp_plugin_prepare_source(const struct GpSource* source) {
+	if (atomic_load_explicit(&plugins_settled, memory_order_acquire)) return;
+
+	FILE* file = open_source(source);
+	if (file == NULL) return;
+
+	uint8_t data[GP_PLUGIN_SNIFF_SIZE];
+	size_t size = fread(data, 1, sizeof(data), file);
+
+	uint64_t offset = gp_plugin_id3_size(data, size);
+	if (offset > 0) {
+		size = offset <= LONG_MAX && fseek(file, (long)offset, SEEK_SET) == 0 ? fread(data, 1, sizeof(data), file) : 0;
+	}
+	fclose(file);
+
+	gp_plugin_prepare(data, size);
+}
+
+double gp_plugin_get_load_seconds(void) {
+	call_once(&plugins_once, init_plugins_mutex);
+	mtx_lock(&plugins_mutex);
+	double seconds = load_seconds;
+	mtx_unlock(&plugins_mutex);
+
+	return seconds;
+}
+
+enum GpResult gp_plugin_free_all(void) {
+	call_once(&plugins_once, init_plugins_mutex);
+	mtx_lock(&plugins_mutex);
+
+	enum GpResult result = GP_RESULT_OK;
+	for (size_t i = 0; i < plugins_size; i++) {
+		uint32_t handle = plugins[i].handle;
+		if (handle == 0) continue;
+
+		for (size_t k = i; k < plugins_size; k++) {
+			if (plugins[k].handle == handle) plugins[k].handle = 0;
+		}
+		if (!BASS_PluginFree(handle)) result = GP_RESULT_ERROR;
+	}
+	for (size_t i = 0; i < plugins_size; i++) plugins[i].failed = false;
+	load_seconds = 0;
+	atomic_store(&plugins_settled, false);
+
+	mtx_unlock(&plugins_mutex);
+
+	return result;
+}
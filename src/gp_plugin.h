@@ -0,0 +1,41 @@
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "grass_player.h"
+#include "gp_source.h"
+
+#define GP_PLUGIN_SNIFF_SIZE 64
+#define GP_ID3_HEADER_SIZE 10
+
+#ifdef _WIN32
+#define GP_PLUGIN_DEFAULT_SEARCH_PATH "."
+#define GP_PLUGIN_PREFIX ""
+#define GP_PLUGIN_SUFFIX ".dll"
+#elif defined(__APPLE__)
+#define GP_PLUGIN_DEFAULT_SEARCH_PATH NULL
+#define GP_PLUGIN_PREFIX "lib"
+#define GP_PLUGIN_SUFFIX ".dylib"
+#else
+#define GP_PLUGIN_DEFAULT_SEARCH_PATH NULL
+#define GP_PLUGIN_PREFIX "lib"
+#define GP_PLUGIN_SUFFIX ".so"
+#endif
+
+typedef bool (* GpPluginMatcher)(const uint8_t* data, size_t size);
+
+struct GpPlugin {
+  const char* name;
+  GpPluginMatcher matches;
+  uint32_t handle;
+  bool failed;
+};
+
+enum GpResult gp_plugin_set_search_path(const char* path);
+char* gp_plugin_library_path(const char* search_path, const char* name);
+uint64_t gp_plugin_id3_size(const uint8_t* data, size_t size);
+struct GpPlugin* gp_plugin_detect(const uint8_t* data, size_t size);
+void gp_plugin_prepare(const uint8_t* data, size_t size);
+void gp_plugin_prepare_source(const struct GpSource* source);
+double gp_plugin_get_load_seconds(void);
+enum GpResult gp_plugin_free_all(void);
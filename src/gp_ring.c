@@ -0,0 +1,83 @@
+#include "gp_ring.h"
+#include <stdlib.h>
+#include <string.h>
+
+enum GpResult gp_ring_init(struct GpRing* ring, size_t capacity, size_t element_size) {
+	if (capacity == 0 || (capacity & (capacity - 1)) != 0) return GP_RESULT_ERROR;
+
+	ring->elements = malloc(capacity * element_size);
+	ring->sequences = malloc(capacity * sizeof(atomic_size_t));
+	if (ring->elements == NULL || ring->sequences == NULL) {
+		free(ring->elements);
+		free(ring->sequences);
+		return GP_RESULT_ERROR;
+	}
+
+	for (size_t i = 0; i < capacity; i++) {
+		atomic_init(&ring->sequences[i], i);
+	}
+
+	ring->capacity = capacity;
+	ring->element_size = element_size;
+	atomic_init(&ring->head, 0);
+	atomic_init(&ring->tail, 0);
+
+	return GP_RESULT_OK;
+}
+
+void gp_ring_destroy(struct GpRing* ring) {
+	free(ring->elements);
+	free(ring->sequences);
+	ring->elements = NULL;
+	ring->sequences = NULL;
+}
+
+bool gp_ring_push(struct GpRing* ring, const void* element) {
+	size_t position = atomic_load_explicit(&ring->head, memory_order_relaxed);
+
+	while (true) {
+		atomic_size_t* sequence = &ring->sequences[position & (ring->capacity - 1)];
+		size_t sequence_value = atomic_load_explicit(sequence, memory_order_acquire);
+		intptr_t difference = (intptr_t)sequence_value - (intptr_t)position;
+
+		if (difference < 0) return false;
+
+		if (difference == 0) {
+			if (atomic_compare_exchange_weak_explicit(&ring->head, &position, position + 1,
+					memory_order_relaxed, memory_order_relaxed)) {
+				memcpy(ring->elements + (position & (ring->capacity - 1)) * ring->element_size, element,
+						ring->element_size);
+				atomic_store_explicit(sequence, position + 1, memory_order_release);
+				return true;
+			}
+		}
+		else {
+			position = atomic_load_explicit(&ring->head, memory_order_relaxed);
+		}
+	}
+}
+
+bool gp_ring_pop(struct GpRing* ring, void* element) {
+	size_t position = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+	while (true) {
+		atomic_size_t* sequence = &ring->sequences[position & (ring->capacity - 1)];
+		size_t sequence_value = atomic_load_explicit(sequence, memory_order_acquire);
+		intptr_t difference = (intptr_t)sequence_value - (intptr_t)(position + 1);
+
+		if (difference < 0) return false;
+
+		if (difference == 0) {
+			if (atomic_compare_exchange_weak_explicit(&ring->tail, &position, position + 1,
+					memory_order_relaxed, memory_order_relaxed)) {
+				memcpy(element, ring->elements + (position & (ring->capacity - 1)) * ring->element_size,
+						ring->element_size);
+				atomic_store_explicit(sequence, position + ring->capacity, memory_order_release);
+				return true;
+			}
+		}
+		else {
+			position = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+		}
+	}
+}
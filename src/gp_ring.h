@@ -0,0 +1,20 @@
+#pragma once
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "grass_player.h"
+
+struct GpRing {
+  uint8_t* elements;
+  atomic_size_t* sequences;
+  size_t capacity;
+  size_t element_size;
+  atomic_size_t head;
+  atomic_size_t tail;
+};
+
+enum GpResult gp_ring_init(struct GpRing* ring, size_t capacity, size_t element_size);
+void gp_ring_destroy(struct GpRing* ring);
+bool gp_ring_push(struct GpRing* ring, const void* element);
+bool gp_ring_pop(struct GpRing* ring, void* element);
@@ -0,0 +1,132 @@
+#include "gp_scanner.h"
+#include <stdlib.h>
+#include <threads.h>
+#include "gp_work_pool.h"
+
+struct GpScanner;
+
+typedef void (* GpScanItem)(struct GpScanner* scanner, size_t path_index, void* result);
+typedef void (* GpScanDeliver)(struct GpScanner* scanner, const void* results, size_t results_size);
+
+struct GpScanner {
+  struct GpMetadataCache* cache;
+  const char** paths;
+  GpScanItem scan_item;
+  GpScanDeliver deliver;
+  size_t result_size;
+  uint8_t* results;
+  size_t* batch_sizes;
+  mtx_t callback_mutex;
+  GpScanCallback scan_callback;
+  GpAnalysisCallback analysis_callback;
+  void* user;
+};
+
+static uint8_t* get_batch_results(struct GpScanner* scanner, size_t worker_index) {
+	return scanner->results + worker_index * GP_SCAN_BATCH_SIZE * scanner->result_size;
+}
+
+static void flush_batch(struct GpScanner* scanner, size_t worker_index) {
+	size_t* batch_size = &scanner->batch_sizes[worker_index];
+	if (*batch_size == 0) return;
+
+	mtx_lock(&scanner->callback_mutex);
+	scanner->deliver(scanner, get_batch_results(scanner, worker_index), *batch_size);
+	mtx_unlock(&scanner->callback_mutex);
+
+	*batch_size = 0;
+}
+
+static void scan_path(size_t path_index, size_t worker_index, void* user) {
+	struct GpScanner* scanner = user;
+	size_t* batch_size = &scanner->batch_sizes[worker_index];
+
+	scanner->scan_item(scanner, path_index,
+			get_batch_results(scanner, worker_index) + *batch_size * scanner->result_size);
+
+	if (++*batch_size == GP_SCAN_BATCH_SIZE) flush_batch(scanner, worker_index);
+}
+
+static enum GpResult run_scanner(struct GpScanner* scanner, size_t paths_size, size_t threads_size) {
+	if (threads_size == 0) threads_size = gp_work_pool_default_threads();
+	if (threads_size > GP_WORK_POOL_MAX_THREADS) threads_size = GP_WORK_POOL_MAX_THREADS;
+
+	scanner->results = calloc(threads_size, GP_SCAN_BATCH_SIZE * scanner->result_size);
+	scanner->batch_sizes = calloc(threads_size, sizeof(size_t));
+	if (scanner->results == NULL || scanner->batch_sizes == NULL
+			|| mtx_init(&scanner->callback_mutex, mtx_plain) != thrd_success) {
+		free(scanner->results);
+		free(scanner->batch_sizes);
+		return GP_RESULT_ERROR;
+	}
+
+	enum GpResult result = gp_work_pool_run(threads_size, paths_size, scan_path, scanner);
+
+	for (size_t i = 0; i < threads_size; i++) flush_batch(scanner, i);
+
+	mtx_destroy(&scanner->callback_mutex);
+	free(scanner->results);
+	free(scanner->batch_sizes);
+
+	return result;
+}
+
+static void probe_path(struct GpScanner* scanner, size_t path_index, void* result) {
+	struct GpScanResult* scan_result = result;
+
+	scan_result->index = path_index;
+	scan_result->info = (struct GpSourceInfo){0};
+	scan_result->valid = gp_metadata_cache_probe(scanner->cache, scanner->paths[path_index], &scan_result->info)
+			== GP_RESULT_OK;
+}
+
+static void deliver_scan_results(struct GpScanner* scanner, const void* results, size_t results_size) {
+	scanner->scan_callback(results, results_size, scanner->user);
+}
+
+enum GpResult gp_scanner_run(struct GpMetadataCache* cache, const char** paths, size_t paths_size,
+		size_t threads_size, GpScanCallback callback, void* user) {
+	if (paths == NULL || callback == NULL) return GP_RESULT_ERROR;
+
+	struct GpScanner scanner = {
+			.cache = cache,
+			.paths = paths,
+			.scan_item = probe_path,
+			.deliver = deliver_scan_results,
+			.result_size = sizeof(struct GpScanResult),
+			.scan_callback = callback,
+			.user = user
+	};
+
+	return run_scanner(&scanner, paths_size, threads_size);
+}
+
+static void analyze_path(struct GpScanner* scanner, size_t path_index, void* result) {
+	struct GpAnalysisResult* analysis_result = result;
+
+	analysis_result->index = path_index;
+	analysis_result->loudness = (struct GpLoudnessInfo){0};
+	analysis_result->valid = gp_metadata_cache_analyze(scanner->cache, scanner->paths[path_index],
+			&analysis_result->loudness) == GP_RESULT_OK;
+}
+
+static void deliver_analysis_results(struct GpScanner* scanner, const void* results, size_t results_size) {
+	scanner->analysis_callback(results, results_size, scanner->user);
+}
+
+enum GpResult gp_scanner_analyze(struct GpMetadataCache* cache, const char** paths, size_t paths_size,
+		size_t threads_size, GpAnalysisCallback callback, void* user) {
+	if (paths == NULL || callback == NULL) return GP_RESULT_ERROR;
+
+	struct GpScanner scanner = {
+			.cache = cache,
+			.paths = paths,
+			.scan_item = analyze_path,
+			.deliver = deliver_analysis_results,
+			.result_size = sizeof(struct GpAnalysisResult),
+			.analysis_callback = callback,
+			.user = user
+	};
+
+	return run_scanner(&scanner, paths_size, threads_size);
+}
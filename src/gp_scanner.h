@@ -0,0 +1,11 @@
+#pragma once
+#include <stddef.h>
+#include "grass_player.h"
+#include "gp_metadata_cache.h"
+
+#define GP_SCAN_BATCH_SIZE 64
+
+enum GpResult gp_scanner_run(struct GpMetadataCache* cache, const char** paths, size_t paths_size,
+		size_t threads_size, GpScanCallback callback, void* user);
+enum GpResult gp_scanner_analyze(struct GpMetadataCache* cache, const char** paths, size_t paths_size,
+		size_t threads_size, GpAnalysisCallback callback, void* user);
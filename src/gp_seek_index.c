@@ -0,0 +1,290 @@
+#include "gp_seek_index.h"
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bass.h"
+#include "gp_plugin.h"
+
+static uint8_t crc_8(const uint8_t* data, size_t size) {
+	uint8_t crc = 0;
+	for (size_t i = 0; i < size; i++) {
+		crc ^= data[i];
+		for (size_t bit = 0; bit < 8; bit++) crc = (uint8_t)((crc & 0x80) != 0 ? (crc << 1) ^ 0x07 : crc << 1);
+	}
+
+	return crc;
+}
+
+static uint32_t read_u24(const uint8_t* data) {
+	return (uint32_t)data[0] << 16 | (uint32_t)data[1] << 8 | data[2];
+}
+
+static void write_u64(uint8_t* data, uint64_t value) {
+	for (size_t i = 0; i < 8; i++) data[i] = (uint8_t)(value >> (56 - i * 8));
+}
+
+size_t gp_flac_parse_frame_header(const uint8_t* data, size_t size, uint32_t block_size, uint64_t* sample,
+		uint32_t* frame_samples) {
+	if (size < 6 || data[0] != 0xff || (data[1] & 0xfe) != 0xf8) return 0;
+
+	bool variable = (data[1] & 1) != 0;
+	uint8_t block_size_code = data[2] >> 4;
+	uint8_t sample_rate_code = data[2] & 0x0f;
+	if (block_size_code == 0 || sample_rate_code == 0x0f) return 0;
+	if ((data[3] >> 4) > 10 || ((data[3] >> 1) & 7) == 3 || (data[3] & 1) != 0) return 0;
+
+	uint8_t lead = data[4];
+	size_t extra_size;
+	uint64_t number;
+	if (lead < 0x80) extra_size = 0, number = lead;
+	else if ((lead & 0xe0) == 0xc0) extra_size = 1, number = lead & 0x1f;
+	else if ((lead & 0xf0) == 0xe0) extra_size = 2, number = lead & 0x0f;
+	else if ((lead & 0xf8) == 0xf0) extra_size = 3, number = lead & 0x07;
+	else if ((lead & 0xfc) == 0xf8) extra_size = 4, number = lead & 0x03;
+	else if ((lead & 0xfe) == 0xfc) extra_size = 5, number = lead & 0x01;
+	else if (lead == 0xfe) extra_size = 6, number = 0;
+	else return 0;
+
+	size_t i = 5;
+	for (size_t k = 0; k < extra_size; k++, i++) {
+		if (i >= size || (data[i] & 0xc0) != 0x80) return 0;
+		number = number << 6 | (data[i] & 0x3f);
+	}
+
+	if (i + 4 > size) return 0;
+
+	if (block_size_code == 1) *frame_samples = 192;
+	else if (block_size_code <= 5) *frame_samples = 576u << (block_size_code - 2);
+	else if (block_size_code == 6) *frame_samples = data[i++] + 1u;
+	else if (block_size_code == 7) *frame_samples = ((uint32_t)data[i] << 8 | data[i + 1]) + 1, i += 2;
+	else *frame_samples = 256u << (block_size_code - 8);
+
+	if (sample_rate_code == 12) i += 1;
+	else if (sample_rate_code == 13 || sample_rate_code == 14) i += 2;
+
+	if (crc_8(data, i) != data[i]) return 0;
+
+	*sample = variable ? number : number * block_size;
+	return i + 1;
+}
+
+static bool parse_metadata(struct GpSeekIndex* index, uint32_t* sample_rate) {
+	const uint8_t* data = index->file_map->data;
+	uint64_t size = index->file_map->size;
+	uint64_t offset = 0;
+
+	if (size >= 10 && memcmp(data, "ID3", 3) == 0) {
+		offset = 10 + ((uint64_t)(data[6] & 0x7f) << 21 | (uint64_t)(data[7] & 0x7f) << 14
+				| (uint64_t)(data[8] & 0x7f) << 7 | (data[9] & 0x7f));
+		if ((data[5] & 0x10) != 0) offset += 10;
+	}
+
+	if (offset + 4 > size || memcmp(data + offset, "fLaC", 4) != 0) return false;
+	offset += 4;
+
+	bool has_seek_table = false;
+	*sample_rate = 0;
+
+	for (bool last = false; !last;) {
+		if (offset + 4 > size) return false;
+
+		uint8_t type = data[offset] & 0x7f;
+		uint32_t length = read_u24(data + offset + 1);
+		last = (data[offset] & 0x80) != 0;
+		if (offset + 4 + length > size) return false;
+
+		if (type == 0 && length >= 18) {
+			const uint8_t* stream_info = data + offset + 4;
+			index->block_size = (uint32_t)stream_info[2] << 8 | stream_info[3];
+			*sample_rate = (uint32_t)stream_info[10] << 12 | (uint32_t)stream_info[11] << 4 | stream_info[12] >> 4;
+		}
+		if (type == GP_FLAC_METADATA_SEEKTABLE && length > 0) has_seek_table = true;
+
+		index->last_header_offset = offset;
+		offset += 4 + length;
+	}
+
+	index->frame_offset = offset;
+
+	return !has_seek_table && *sample_rate > 0 && offset <= UINT32_MAX;
+}
+
+static void load_seek_table(struct GpSeekIndex* index) {
+	size_t seek_points_size;
+	uint8_t* seek_points = gp_metadata_cache_get_seek_points(index->cache, index->source,
+			(uint32_t)index->frame_offset, &seek_points_size);
+	if (seek_points == NULL) return;
+
+	size_t seek_points_bytes = seek_points_size * GP_SEEK_POINT_SIZE;
+	index->seek_table = malloc(4 + seek_points_bytes);
+	if (index->seek_table != NULL) {
+		index->seek_table[0] = 0x80 | GP_FLAC_METADATA_SEEKTABLE;
+		index->seek_table[1] = (uint8_t)(seek_points_bytes >> 16);
+		index->seek_table[2] = (uint8_t)(seek_points_bytes >> 8);
+		index->seek_table[3] = (uint8_t)seek_points_bytes;
+		memcpy(index->seek_table + 4, seek_points, seek_points_bytes);
+		index->seek_table_size = 4 + seek_points_bytes;
+		index->loaded_seek_points_size = seek_points_size;
+	}
+
+	free(seek_points);
+}
+
+struct GpSeekIndex* gp_seek_index_open(struct GpMetadataCache* cache, const struct GpSource* source,
+		struct GpFileMap* file_map) {
+	struct GpSeekIndex* index = calloc(1, sizeof(struct GpSeekIndex));
+	if (index == NULL) return NULL;
+
+	index->cache = cache;
+	index->file_map = file_map;
+
+	uint32_t sample_rate;
+	if (!parse_metadata(index, &sample_rate) || (index->source = gp_new_source(source->path)) == NULL) {
+		index->file_map = NULL;
+		gp_seek_index_close(index);
+		return NULL;
+	}
+
+	index->interval = (uint64_t)(sample_rate * GP_SEEK_INDEX_INTERVAL_SECONDS);
+	index->scanned_offset = index->frame_offset;
+	load_seek_table(index);
+
+	return index;
+}
+
+void gp_seek_index_close(struct GpSeekIndex* index) {
+	if (index == NULL) return;
+
+	if (index->file_map != NULL && index->seek_points_size > index->loaded_seek_points_size) {
+		gp_metadata_cache_set_seek_points(index->cache, index->source, (uint32_t)index->frame_offset,
+				index->seek_points, index->seek_points_size);
+	}
+
+	gp_file_map_close(index->file_map);
+	gp_free_source(index->source);
+	free(index->seek_table);
+	free(index->seek_points);
+	free(index);
+}
+
+uint64_t gp_seek_index_size(const struct GpSeekIndex* index) {
+	return index->file_map->size + index->seek_table_size;
+}
+
+static void add_seek_point(struct GpSeekIndex* index, uint64_t sample, uint64_t offset, uint32_t frame_samples) {
+	if (index->seek_points_size == index->seek_points_capacity) {
+		size_t capacity = index->seek_points_capacity > 0 ? index->seek_points_capacity * 2 : 256;
+		uint8_t* seek_points = realloc(index->seek_points, capacity * GP_SEEK_POINT_SIZE);
+		if (seek_points == NULL) return;
+
+		index->seek_points = seek_points;
+		index->seek_points_capacity = capacity;
+	}
+
+	uint8_t* seek_point = index->seek_points + index->seek_points_size++ * GP_SEEK_POINT_SIZE;
+	write_u64(seek_point, sample);
+	write_u64(seek_point + 8, offset - index->frame_offset);
+	seek_point[16] = (uint8_t)(frame_samples >> 8);
+	seek_point[17] = (uint8_t)frame_samples;
+
+	index->next_point_sample = sample + index->interval;
+}
+
+static void scan_frames(struct GpSeekIndex* index, uint64_t start, uint64_t end) {
+	if (start > index->scanned_offset || end <= index->scanned_offset) return;
+
+	const uint8_t* data = index->file_map->data;
+	uint64_t size = index->file_map->size;
+	uint64_t offset = index->scanned_offset;
+
+	while (offset < end) {
+		const uint8_t* sync = memchr(data + offset, 0xff, (size_t)(end - offset));
+		if (sync == NULL) break;
+		offset = (uint64_t)(sync - data);
+
+		uint64_t sample;
+		uint32_t frame_samples;
+		size_t header_size = gp_flac_parse_frame_header(sync, (size_t)(size - offset), index->block_size, &sample,
+				&frame_samples);
+
+		if (header_size == 0 || sample != index->next_sample) {
+			offset++;
+			continue;
+		}
+
+		if (sample >= index->next_point_sample) add_seek_point(index, sample, offset, frame_samples);
+		index->next_sample = sample + frame_samples;
+		offset += header_size;
+	}
+
+	index->scanned_offset = end;
+}
+
+size_t gp_seek_index_read(struct GpSeekIndex* index, void* buffer, size_t length) {
+	uint8_t* destination = buffer;
+	uint64_t size = gp_seek_index_size(index);
+	uint64_t table_end = index->frame_offset + index->seek_table_size;
+	size_t read_size = 0;
+
+	while (read_size < length && index->position < size) {
+		uint64_t position = index->position;
+		size_t chunk_size = length - read_size;
+
+		if (position < index->frame_offset) {
+			if (chunk_size > index->frame_offset - position) chunk_size = (size_t)(index->frame_offset - position);
+			memcpy(destination, index->file_map->data + position, chunk_size);
+
+			if (index->seek_table != NULL && index->last_header_offset >= position
+					&& index->last_header_offset < position + chunk_size) {
+				destination[index->last_header_offset - position] &= 0x7f;
+			}
+		} else if (position < table_end) {
+			if (chunk_size > table_end - position) chunk_size = (size_t)(table_end - position);
+			memcpy(destination, index->seek_table + (position - index->frame_offset), chunk_size);
+		} else {
+			uint64_t offset = position - index->seek_table_size;
+			if (chunk_size > index->file_map->size - offset) chunk_size = (size_t)(index->file_map->size - offset);
+			memcpy(destination, index->file_map->data + offset, chunk_size);
+			scan_frames(index, offset, offset + chunk_size);
+		}
+
+		destination += chunk_size;
+		read_size += chunk_size;
+		index->position += chunk_size;
+	}
+
+	return read_size;
+}
+
+static void CALLBACK handle_file_close(void* user) {
+	gp_seek_index_close(user);
+}
+
+static QWORD CALLBACK handle_file_length(void* user) {
+	return gp_seek_index_size(user);
+}
+
+static DWORD CALLBACK handle_file_read(void* buffer, DWORD length, void* user) {
+	return (DWORD)gp_seek_index_read(user, buffer, length);
+}
+
+static BOOL CALLBACK handle_file_seek(QWORD offset, void* user) {
+	struct GpSeekIndex* index = user;
+	if (offset > gp_seek_index_size(index)) return FALSE;
+
+	index->position = offset;
+	return TRUE;
+}
+
+static const BASS_FILEPROCS file_procs = {
+		handle_file_close,
+		handle_file_length,
+		handle_file_read,
+		handle_file_seek
+};
+
+uint32_t gp_seek_index_create_stream(struct GpSeekIndex* index, uint32_t flags) {
+	gp_plugin_prepare(index->file_map->data, (size_t)index->file_map->size);
+
+	return BASS_StreamCreateFileUser(STREAMFILE_NOBUFFER, flags, &file_procs, index);
+}
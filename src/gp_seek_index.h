@@ -0,0 +1,39 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "grass_player.h"
+#include "gp_file_map.h"
+#include "gp_metadata_cache.h"
+
+#define GP_SEEK_INDEX_INTERVAL_SECONDS 1.0
+#define GP_FLAC_FRAME_HEADER_MAX_SIZE 16
+#define GP_FLAC_METADATA_SEEKTABLE 3
+
+struct GpSeekIndex {
+  struct GpFileMap* file_map;
+  struct GpMetadataCache* cache;
+  struct GpSource* source;
+  uint64_t frame_offset;
+  uint64_t last_header_offset;
+  uint8_t* seek_table;
+  size_t seek_table_size;
+  uint64_t position;
+  uint32_t block_size;
+  uint64_t interval;
+  uint64_t scanned_offset;
+  uint64_t next_sample;
+  uint64_t next_point_sample;
+  uint8_t* seek_points;
+  size_t seek_points_size;
+  size_t seek_points_capacity;
+  size_t loaded_seek_points_size;
+};
+
+struct GpSeekIndex* gp_seek_index_open(struct GpMetadataCache* cache, const struct GpSource* source,
+		struct GpFileMap* file_map);
+void gp_seek_index_close(struct GpSeekIndex* index);
+uint64_t gp_seek_index_size(const struct GpSeekIndex* index);
+size_t gp_seek_index_read(struct GpSeekIndex* index, void* buffer, size_t length);
+uint32_t gp_seek_index_create_stream(struct GpSeekIndex* index, uint32_t flags);
+size_t gp_flac_parse_frame_header(const uint8_t* data, size_t size, uint32_t block_size, uint64_t* sample,
+		uint32_t* frame_samples);
@@ -0,0 +1,265 @@
+#include "gp_sink.h"
+#include <stdlib.h>
+#include <string.h>
+#include "bass.h"
+#include "gp_clock.h"
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+size_t gp_sink_encode(enum GpSinkFormat format, const float* samples, size_t samples_size, uint8_t* destination) {
+	if (format == GP_SINK_FORMAT_FLOAT) {
+		memcpy(destination, samples, samples_size * sizeof(float));
+		return samples_size * sizeof(float);
+	}
+
+	int16_t* pcm = (int16_t*)destination;
+	for (size_t i = 0; i < samples_size; i++) {
+		float sample = samples[i] * 32768.0f;
+		if (sample > 32767.0f) sample = 32767.0f;
+		if (sample < -32768.0f) sample = -32768.0f;
+		pcm[i] = (int16_t)sample;
+	}
+
+	return samples_size * sizeof(int16_t);
+}
+
+void gp_sink_append(struct GpSink* sink, const uint8_t* data, size_t size) {
+	size_t offset = (size_t)(sink->written % GP_SINK_RING_SIZE);
+	size_t head_size = GP_SINK_RING_SIZE - offset < size ? GP_SINK_RING_SIZE - offset : size;
+	memcpy(sink->ring + offset, data, head_size);
+	memcpy(sink->ring, data + head_size, size - head_size);
+	sink->written += size;
+}
+
+#ifndef _WIN32
+static void drop_client(struct GpSink* sink, size_t index) {
+	close(sink->clients[index].fd);
+	sink->clients[index] = sink->clients[--sink->clients_size];
+	atomic_fetch_add(&sink->dropped_clients, 1);
+	atomic_store(&sink->connected_clients, sink->clients_size);
+}
+
+static void skip_client(struct GpSink* sink, struct GpSinkClient* client) {
+	uint64_t frame_offset = client->position % sink->frame_size;
+	uint64_t position = sink->written - (frame_offset != 0 ? sink->frame_size - frame_offset : 0);
+
+	atomic_fetch_add(&sink->skipped_bytes, position - client->position);
+	client->position = position;
+}
+
+bool gp_sink_send(struct GpSink* sink, struct GpSinkClient* client) {
+	if (sink->written - client->position > GP_SINK_RING_SIZE) skip_client(sink, client);
+
+	while (client->position < sink->written) {
+		size_t offset = (size_t)(client->position % GP_SINK_RING_SIZE);
+		size_t size = (size_t)(sink->written - client->position);
+		if (size > GP_SINK_RING_SIZE - offset) size = GP_SINK_RING_SIZE - offset;
+
+		ssize_t sent_size = sink->fifo
+				? write(client->fd, sink->ring + offset, size)
+				: send(client->fd, sink->ring + offset, size, MSG_DONTWAIT | MSG_NOSIGNAL);
+		if (sent_size < 0) return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+		if (sent_size == 0) return true;
+
+		client->position += (uint64_t)sent_size;
+	}
+
+	return true;
+}
+
+static void accept_clients(struct GpSink* sink) {
+	if (sink->fifo) {
+		if (sink->clients_size > 0) return;
+
+		int fd = open(sink->path, O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+		if (fd == -1) return;
+
+		sink->clients[sink->clients_size++] = (struct GpSinkClient){fd, sink->written};
+		atomic_store(&sink->connected_clients, sink->clients_size);
+		return;
+	}
+
+	while (true) {
+		int fd = accept(sink->listen_fd, NULL, NULL);
+		if (fd == -1) return;
+
+		if (sink->clients_size == GP_SINK_MAX_CLIENTS) {
+			close(fd);
+			atomic_fetch_add(&sink->dropped_clients, 1);
+			continue;
+		}
+
+		fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+		sink->clients[sink->clients_size++] = (struct GpSinkClient){fd, sink->written};
+		atomic_store(&sink->connected_clients, sink->clients_size);
+	}
+}
+
+static void pull_mixer(struct GpSink* sink, double* start, uint64_t* pulled_frames) {
+	if (atomic_load(sink->playback_state) != GP_PLAYBACK_STATE_PLAYING) {
+		*start = 0;
+		return;
+	}
+
+	double now = gp_clock_now();
+	if (*start == 0) {
+		*start = now;
+		*pulled_frames = 0;
+	}
+
+	uint64_t due_frames = (uint64_t)((now - *start + GP_SINK_LEAD_SECONDS) * sink->sample_rate);
+	float samples[GP_SINK_BLOCK_FRAMES * GP_SINK_CHANNELS];
+	uint8_t encoded[sizeof(samples)];
+
+	while (*pulled_frames < due_frames) {
+		uint64_t frames = due_frames - *pulled_frames;
+		if (frames > GP_SINK_BLOCK_FRAMES) frames = GP_SINK_BLOCK_FRAMES;
+
+		uint32_t read_bytes = BASS_ChannelGetData(sink->mixer_stream_handle, samples,
+				(uint32_t)(frames * GP_SINK_CHANNELS * sizeof(float)) | BASS_DATA_FLOAT);
+		if (read_bytes == (uint32_t)-1 || read_bytes == 0) {
+			*pulled_frames = due_frames;
+			return;
+		}
+
+		size_t samples_size = read_bytes / sizeof(float);
+		gp_sink_append(sink, encoded, gp_sink_encode(sink->format, samples, samples_size, encoded));
+		*pulled_frames += samples_size / GP_SINK_CHANNELS;
+	}
+}
+
+static int run_sink_thread(void* arg) {
+	struct GpSink* sink = arg;
+	double start = 0;
+	uint64_t pulled_frames = 0;
+
+	sigset_t signals;
+	sigemptyset(&signals);
+	sigaddset(&signals, SIGPIPE);
+	pthread_sigmask(SIG_BLOCK, &signals, NULL);
+
+	while (atomic_load(&sink->running)) {
+		struct pollfd listen_poll = {sink->listen_fd, POLLIN, 0};
+		poll(&listen_poll, sink->fifo ? 0 : 1, GP_SINK_PERIOD_MS);
+
+		accept_clients(sink);
+		pull_mixer(sink, &start, &pulled_frames);
+
+		for (size_t i = 0; i < sink->clients_size;) {
+			if (gp_sink_send(sink, &sink->clients[i])) i++;
+			else drop_client(sink, i);
+		}
+	}
+
+	return 0;
+}
+
+static enum GpResult open_endpoint(struct GpSink* sink) {
+	struct stat path_stat;
+	if (stat(sink->path, &path_stat) == 0 && S_ISFIFO(path_stat.st_mode)) {
+		sink->fifo = true;
+		return GP_RESULT_OK;
+	}
+
+	struct sockaddr_un address = {0};
+	address.sun_family = AF_UNIX;
+	if (strlen(sink->path) >= sizeof(address.sun_path)) return GP_RESULT_ERROR;
+	strcpy(address.sun_path, sink->path);
+
+	if (lstat(sink->path, &path_stat) == 0 && (!S_ISSOCK(path_stat.st_mode) || unlink(sink->path) != 0)) {
+		return GP_RESULT_ERROR;
+	}
+
+	sink->listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (sink->listen_fd == -1) return GP_RESULT_ERROR;
+
+	if (bind(sink->listen_fd, (struct sockaddr*)&address, sizeof(address)) != 0
+			|| listen(sink->listen_fd, GP_SINK_MAX_CLIENTS) != 0) {
+		return GP_RESULT_ERROR;
+	}
+
+	return GP_RESULT_OK;
+}
+
+struct GpSink* gp_sink_open(const char* path, enum GpSinkFormat format, uint32_t mixer_stream_handle,
+		uint32_t sample_rate, const atomic_int* playback_state) {
+	if (path == NULL || format > GP_SINK_FORMAT_S16) return NULL;
+
+	struct GpSink* sink = calloc(1, sizeof(struct GpSink));
+	if (sink == NULL) return NULL;
+
+	sink->listen_fd = -1;
+	sink->path = malloc(strlen(path) + 1);
+	sink->format = format;
+	sink->frame_size = GP_SINK_CHANNELS * (format == GP_SINK_FORMAT_FLOAT ? sizeof(float) : sizeof(int16_t));
+	sink->mixer_stream_handle = mixer_stream_handle;
+	sink->sample_rate = sample_rate;
+	sink->playback_state = playback_state;
+	atomic_init(&sink->running, true);
+
+	if (sink->path == NULL) {
+		free(sink);
+		return NULL;
+	}
+	strcpy(sink->path, path);
+
+	if (open_endpoint(sink) != GP_RESULT_OK || thrd_create(&sink->thread, run_sink_thread, sink) != thrd_success) {
+		if (sink->listen_fd != -1) close(sink->listen_fd);
+		free(sink->path);
+		free(sink);
+		return NULL;
+	}
+
+	return sink;
+}
+
+void gp_sink_close(struct GpSink* sink) {
+	if (sink == NULL) return;
+
+	atomic_store(&sink->running, false);
+	thrd_join(sink->thread, NULL);
+
+	for (size_t i = 0; i < sink->clients_size; i++) close(sink->clients[i].fd);
+	if (sink->listen_fd != -1) {
+		close(sink->listen_fd);
+		unlink(sink->path);
+	}
+
+	free(sink->path);
+	free(sink);
+}
+#else
+bool gp_sink_send(struct GpSink* sink, struct GpSinkClient* client) {
+	(void)sink;
+	(void)client;
+	return false;
+}
+
+struct GpSink* gp_sink_open(const char* path, enum GpSinkFormat format, uint32_t mixer_stream_handle,
+		uint32_t sample_rate, const atomic_int* playback_state) {
+	(void)path;
+	(void)format;
+	(void)mixer_stream_handle;
+	(void)sample_rate;
+	(void)playback_state;
+	return NULL;
+}
+
+void gp_sink_close(struct GpSink* sink) {
+	(void)sink;
+}
+#endif
+
+void gp_sink_get_stats(struct GpSink* sink, struct GpSinkStats* stats) {
+	stats->clients = atomic_load(&sink->connected_clients);
+	stats->skipped_bytes = atomic_load(&sink->skipped_bytes);
+	stats->dropped_clients = atomic_load(&sink->dropped_clients);
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <threads.h>
+#include "grass_player.h"
+
+#define GP_SINK_CHANNELS 2
+#define GP_SINK_RING_SIZE (1 << 20)
+#define GP_SINK_MAX_CLIENTS 32
+#define GP_SINK_PERIOD_MS 10
+#define GP_SINK_LEAD_SECONDS 0.1
+#define GP_SINK_BLOCK_FRAMES 1024
+
+struct GpSinkClient {
+  int fd;
+  uint64_t position;
+};
+
+struct GpSink {
+  int listen_fd;
+  int fifo_fd;
+  bool fifo;
+  char* path;
+  enum GpSinkFormat format;
+  size_t frame_size;
+  uint32_t mixer_stream_handle;
+  uint32_t sample_rate;
+  const atomic_int* playback_state;
+  uint8_t ring[GP_SINK_RING_SIZE];
+  uint64_t written;
+  struct GpSinkClient clients[GP_SINK_MAX_CLIENTS];
+  size_t clients_size;
+  atomic_size_t connected_clients;
+  atomic_uint_least64_t skipped_bytes;
+  atomic_uint_least64_t dropped_clients;
+  atomic_bool running;
+  thrd_t thread;
+};
+
+struct GpSink* gp_sink_open(const char* path, enum GpSinkFormat format, uint32_t mixer_stream_handle,
+		uint32_t sample_rate, const atomic_int* playback_state);
+void gp_sink_close(struct GpSink* sink);
+void gp_sink_get_stats(struct GpSink* sink, struct GpSinkStats* stats);
+size_t gp_sink_encode(enum GpSinkFormat format, const float* samples, size_t samples_size, uint8_t* destination);
+void gp_sink_append(struct GpSink* sink, const uint8_t* data, size_t size);
+bool gp_sink_send(struct GpSink* sink, struct GpSinkClient* client);
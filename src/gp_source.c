@@ -1,21 +1,11 @@
 #include <stdlib.h>
 #include <string.h>
+#ifdef _WIN32
 #include <windows.h>
+#endif
+#include "bass.h"
 #include "gp_source.h"
-
-const wchar_t* gp_utf_8_to_utf_16(const char* utf8) {
-	const int utf8_length = (int)strlen(utf8);
-	const int wstr_length = MultiByteToWideChar(CP_UTF8, 0, utf8, utf8_length, NULL, 0);
-
-	wchar_t* wstr = (wchar_t*)malloc(sizeof(wchar_t) * (wstr_length + 1));
-
-	if (wstr == NULL) return NULL;
-
-	MultiByteToWideChar(CP_UTF8, 0, utf8, utf8_length, wstr, wstr_length);
-	wstr[wstr_length] = L'\0';
-
-	return wstr;
-}
+#include "gp_plugin.h"
 
 struct GpSource* gp_new_source(const char* path) {
 	struct GpSource* source = malloc(sizeof(struct GpSource));
@@ -31,14 +21,6 @@ struct GpSource* gp_new_source(const char* path) {
 
 	memcpy((void*)source->path, path, source->size + 1);
 
-	source->wpath = gp_utf_8_to_utf_16(source->path);
-
-	if (source->wpath == NULL) {
-		free((void*)source->path);
-		free(source);
-		return NULL;
-	}
-
 	return source;
 }
 
@@ -46,6 +28,43 @@ void gp_free_source(struct GpSource* source) {
 	if (source == NULL) return;
 
 	free((void*)source->path);
-	free((void*)source->wpath);
 	free(source);
 }
+
+const GpNativeChar* gp_source_native_path(const struct GpSource* source) {
+#ifdef _WIN32
+	int length = source->size > 0
+			? MultiByteToWideChar(CP_UTF8, 0, source->path, (int)source->size, NULL, 0)
+			: 0;
+
+	wchar_t* native_path = malloc(sizeof(wchar_t) * ((size_t)length + 1));
+	if (native_path == NULL) return NULL;
+
+	if (length > 0) MultiByteToWideChar(CP_UTF8, 0, source->path, (int)source->size, native_path, length);
+	native_path[length] = L'\0';
+
+	return native_path;
+#else
+	return source->path;
+#endif
+}
+
+void gp_source_free_native_path(const struct GpSource* source, const GpNativeChar* native_path) {
+	if ((const void*)native_path != (const void*)source->path) free((void*)native_path);
+}
+
+uint32_t gp_source_create_stream(const struct GpSource* source, uint32_t flags) {
+	gp_plugin_prepare_source(source);
+
+	const GpNativeChar* native_path = gp_source_native_path(source);
+	if (native_path == NULL) return 0;
+
+#ifdef _WIN32
+	flags |= BASS_UNICODE;
+#endif
+
+	uint32_t stream_handle = BASS_StreamCreateFile(FALSE, native_path, 0, 0, flags);
+	gp_source_free_native_path(source, native_path);
+
+	return stream_handle;
+}
@@ -1,12 +1,21 @@
 #pragma once
+#include <stddef.h>
 #include <stdint.h>
 #include <wchar.h>
 
+#ifdef _WIN32
+typedef wchar_t GpNativeChar;
+#else
+typedef char GpNativeChar;
+#endif
+
 struct GpSource {
   const char* path;
   size_t size;
-  const wchar_t* wpath;
 };
 
 struct GpSource* gp_new_source(const char* path);
 void gp_free_source(struct GpSource* source);
+const GpNativeChar* gp_source_native_path(const struct GpSource* source);
+void gp_source_free_native_path(const struct GpSource* source, const GpNativeChar* native_path);
+uint32_t gp_source_create_stream(const struct GpSource* source, uint32_t flags);
@@ -1,40 +1,170 @@
 #include "gp_source_list.h"
 #include <stdlib.h>
+#include <string.h>
+
+static enum GpResult reserve(void** buffer, size_t* capacity, size_t required, size_t element_size) {
+	if (*buffer != NULL && required <= *capacity) return GP_RESULT_OK;
+
+	size_t new_capacity = *capacity * 2;
+	if (new_capacity < required) new_capacity = required;
+	if (new_capacity == 0) new_capacity = 1;
+
+	void* new_buffer = realloc(*buffer, new_capacity * element_size);
+	if (new_buffer == NULL) return GP_RESULT_ERROR;
+
+	*buffer = new_buffer;
+	*capacity = new_capacity;
+	return GP_RESULT_OK;
+}
+
+static enum GpResult compact(struct GpSourceList* source_list) {
+	size_t pool_size = source_list->pool_size - source_list->pool_garbage_size;
+
+	char* pool = malloc(pool_size > 0 ? pool_size : 1);
+	if (pool == NULL) return GP_RESULT_ERROR;
+
+	size_t path_offset = 0;
+
+	for (size_t i = 0; i < source_list->size; i++) {
+		struct GpSourceEntry* entry = &source_list->entries[i];
+
+		memcpy(pool + path_offset, source_list->pool + entry->path_offset, entry->size + 1);
+
+		entry->path_offset = path_offset;
+		path_offset += entry->size + 1;
+	}
+
+	free(source_list->pool);
+
+	source_list->pool = pool;
+	source_list->pool_size = pool_size;
+	source_list->pool_capacity = pool_size;
+	source_list->pool_garbage_size = 0;
+
+	return GP_RESULT_OK;
+}
 
 struct GpSourceList* gp_new_source_list(const char** paths, size_t size) {
-	struct GpSourceList* source_list = malloc(sizeof(struct GpSourceList));
+	struct GpSourceList* source_list = calloc(1, sizeof(struct GpSourceList));
 	if (source_list == NULL) return NULL;
 
-	source_list->list = malloc(sizeof(struct GpSource*) * size);
-	if (source_list->list == NULL) {
-		free(source_list);
+	if (gp_source_list_insert(source_list, 0, paths, size) != GP_RESULT_OK) {
+		gp_free_source_list(source_list);
 		return NULL;
 	}
 
-	for (size_t i = 0; i < size; i++) {
-		source_list->list[i] = gp_new_source(paths[i]);
-		if (source_list->list[i] == NULL) {
-			for (size_t j = 0; j < i; j++) {
-				gp_free_source(source_list->list[j]);
-			}
-			free(source_list->list);
-			free(source_list);
-			return NULL;
-		}
-	}
-
-	source_list->size = size;
 	return source_list;
 
 }
 
 void gp_free_source_list(struct GpSourceList* source_list) {
-	if (source_list == NULL || source_list->list == NULL) return;
+	if (source_list == NULL) return;
 
-	for (size_t i = 0; i < source_list->size; i++) {
-		gp_free_source(source_list->list[i]);
+	free(source_list->pool);
+	free(source_list->entries);
+	free(source_list);
+}
+
+struct GpSource gp_source_list_get(const struct GpSourceList* source_list, size_t index) {
+	const struct GpSourceEntry* entry = &source_list->entries[index];
+
+	return (struct GpSource){
+			source_list->pool + entry->path_offset,
+			entry->size
+	};
+}
+
+enum GpResult gp_source_list_insert(struct GpSourceList* source_list, size_t index, const char** paths,
+		size_t size) {
+	if (index > source_list->size) return GP_RESULT_ERROR;
+
+	size_t pool_size = source_list->pool_size;
+	for (size_t i = 0; i < size; i++) pool_size += strlen(paths[i]) + 1;
+
+	if (reserve((void**)&source_list->entries, &source_list->capacity, source_list->size + size,
+			sizeof(struct GpSourceEntry)) != GP_RESULT_OK
+			|| reserve((void**)&source_list->pool, &source_list->pool_capacity, pool_size,
+					sizeof(char)) != GP_RESULT_OK) {
+		return GP_RESULT_ERROR;
 	}
 
-	free(source_list->list);
-	free(source_list);
+	memmove(&source_list->entries[index + size], &source_list->entries[index],
+			sizeof(struct GpSourceEntry) * (source_list->size - index));
+
+	for (size_t i = 0; i < size; i++) {
+		struct GpSourceEntry* entry = &source_list->entries[index + i];
+		entry->size = strlen(paths[i]);
+		entry->path_offset = source_list->pool_size;
+
+		memcpy(source_list->pool + entry->path_offset, paths[i], entry->size + 1);
+
+		source_list->pool_size += entry->size + 1;
+	}
+
+	source_list->size += size;
+	return GP_RESULT_OK;
+}
+
+enum GpResult gp_source_list_insert_list(struct GpSourceList* source_list, size_t index,
+		const struct GpSourceList* other) {
+	if (index > source_list->size) return GP_RESULT_ERROR;
+
+	size_t pool_size = source_list->pool_size + other->pool_size - other->pool_garbage_size;
+
+	if (reserve((void**)&source_list->entries, &source_list->capacity, source_list->size + other->size,
+			sizeof(struct GpSourceEntry)) != GP_RESULT_OK
+			|| reserve((void**)&source_list->pool, &source_list->pool_capacity, pool_size,
+					sizeof(char)) != GP_RESULT_OK) {
+		return GP_RESULT_ERROR;
+	}
+
+	memmove(&source_list->entries[index + other->size], &source_list->entries[index],
+			sizeof(struct GpSourceEntry) * (source_list->size - index));
+
+	for (size_t i = 0; i < other->size; i++) {
+		const struct GpSourceEntry* other_entry = &other->entries[i];
+		struct GpSourceEntry* entry = &source_list->entries[index + i];
+		entry->size = other_entry->size;
+		entry->path_offset = source_list->pool_size;
+
+		memcpy(source_list->pool + entry->path_offset, other->pool + other_entry->path_offset,
+				entry->size + 1);
+
+		source_list->pool_size += entry->size + 1;
+	}
+
+	source_list->size += other->size;
+	return GP_RESULT_OK;
+}
+
+enum GpResult gp_source_list_remove(struct GpSourceList* source_list, size_t index, size_t size) {
+	if (index > source_list->size || size > source_list->size - index) return GP_RESULT_ERROR;
+
+	for (size_t i = index; i < index + size; i++) source_list->pool_garbage_size += source_list->entries[i].size + 1;
+
+	memmove(&source_list->entries[index], &source_list->entries[index + size],
+			sizeof(struct GpSourceEntry) * (source_list->size - index - size));
+	source_list->size -= size;
+
+	if (source_list->pool_garbage_size > source_list->pool_size / 2) compact(source_list);
+
+	return GP_RESULT_OK;
+}
+
+enum GpResult gp_source_list_move(struct GpSourceList* source_list, size_t from_index, size_t to_index) {
+	if (from_index >= source_list->size || to_index >= source_list->size) return GP_RESULT_ERROR;
+
+	struct GpSourceEntry entry = source_list->entries[from_index];
+
+	if (from_index < to_index) {
+		memmove(&source_list->entries[from_index], &source_list->entries[from_index + 1],
+				sizeof(struct GpSourceEntry) * (to_index - from_index));
+	}
+	else {
+		memmove(&source_list->entries[to_index + 1], &source_list->entries[to_index],
+				sizeof(struct GpSourceEntry) * (from_index - to_index));
+	}
+
+	source_list->entries[to_index] = entry;
+	return GP_RESULT_OK;
 }
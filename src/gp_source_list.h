@@ -1,11 +1,28 @@
 #pragma once
+#include "grass_player.h"
 #include "gp_source.h"
 
+struct GpSourceEntry {
+  size_t path_offset;
+  size_t size;
+};
+
 struct GpSourceList {
-  struct GpSource** list;
+  struct GpSourceEntry* entries;
   size_t size;
+  size_t capacity;
+  char* pool;
+  size_t pool_size;
+  size_t pool_capacity;
+  size_t pool_garbage_size;
 };
 
 struct GpSourceList* gp_new_source_list(const char** paths, size_t size);
 void gp_free_source_list(struct GpSourceList* source_list);
-
+struct GpSource gp_source_list_get(const struct GpSourceList* source_list, size_t index);
+enum GpResult gp_source_list_insert(struct GpSourceList* source_list, size_t index, const char** paths,
+		size_t size);
+enum GpResult gp_source_list_insert_list(struct GpSourceList* source_list, size_t index,
+		const struct GpSourceList* other);
+enum GpResult gp_source_list_remove(struct GpSourceList* source_list, size_t index, size_t size);
+enum GpResult gp_source_list_move(struct GpSourceList* source_list, size_t from_index, size_t to_index);
@@ -0,0 +1,258 @@
+#include "gp_tap.h"
+#include <math.h>
+#include <stdbool.h>
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__)
+#define GP_TAP_SSE2
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define GP_TAP_NEON
+#include <arm_neon.h>
+#endif
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+void gp_fft_stage_scalar(float* real, float* imaginary, size_t size, size_t half,
+		const float* twiddle_real, const float* twiddle_imaginary) {
+	for (size_t block = 0; block < size; block += 2 * half) {
+		for (size_t k = 0; k < half; k++) {
+			size_t a = block + k;
+			size_t b = a + half;
+			float t_real = real[b] * twiddle_real[k] - imaginary[b] * twiddle_imaginary[k];
+			float t_imaginary = real[b] * twiddle_imaginary[k] + imaginary[b] * twiddle_real[k];
+
+			real[b] = real[a] - t_real;
+			imaginary[b] = imaginary[a] - t_imaginary;
+			real[a] += t_real;
+			imaginary[a] += t_imaginary;
+		}
+	}
+}
+
+#ifdef GP_TAP_SSE2
+static void fft_stage_sse2(float* real, float* imaginary, size_t size, size_t half,
+		const float* twiddle_real, const float* twiddle_imaginary) {
+	if (half < 4) {
+		gp_fft_stage_scalar(real, imaginary, size, half, twiddle_real, twiddle_imaginary);
+		return;
+	}
+
+	for (size_t block = 0; block < size; block += 2 * half) {
+		for (size_t k = 0; k < half; k += 4) {
+			size_t a = block + k;
+			size_t b = a + half;
+			__m128 w_real = _mm_loadu_ps(twiddle_real + k);
+			__m128 w_imaginary = _mm_loadu_ps(twiddle_imaginary + k);
+			__m128 b_real = _mm_loadu_ps(real + b);
+			__m128 b_imaginary = _mm_loadu_ps(imaginary + b);
+			__m128 t_real = _mm_sub_ps(_mm_mul_ps(b_real, w_real), _mm_mul_ps(b_imaginary, w_imaginary));
+			__m128 t_imaginary = _mm_add_ps(_mm_mul_ps(b_real, w_imaginary), _mm_mul_ps(b_imaginary, w_real));
+			__m128 a_real = _mm_loadu_ps(real + a);
+			__m128 a_imaginary = _mm_loadu_ps(imaginary + a);
+
+			_mm_storeu_ps(real + a, _mm_add_ps(a_real, t_real));
+			_mm_storeu_ps(imaginary + a, _mm_add_ps(a_imaginary, t_imaginary));
+			_mm_storeu_ps(real + b, _mm_sub_ps(a_real, t_real));
+			_mm_storeu_ps(imaginary + b, _mm_sub_ps(a_imaginary, t_imaginary));
+		}
+	}
+}
+#endif
+
+#ifdef GP_TAP_NEON
+static void fft_stage_neon(float* real, float* imaginary, size_t size, size_t half,
+		const float* twiddle_real, const float* twiddle_imaginary) {
+	if (half < 4) {
+		gp_fft_stage_scalar(real, imaginary, size, half, twiddle_real, twiddle_imaginary);
+		return;
+	}
+
+	for (size_t block = 0; block < size; block += 2 * half) {
+		for (size_t k = 0; k < half; k += 4) {
+			size_t a = block + k;
+			size_t b = a + half;
+			float32x4_t w_real = vld1q_f32(twiddle_real + k);
+			float32x4_t w_imaginary = vld1q_f32(twiddle_imaginary + k);
+			float32x4_t b_real = vld1q_f32(real + b);
+			float32x4_t b_imaginary = vld1q_f32(imaginary + b);
+			float32x4_t t_real = vmlsq_f32(vmulq_f32(b_real, w_real), b_imaginary, w_imaginary);
+			float32x4_t t_imaginary = vmlaq_f32(vmulq_f32(b_real, w_imaginary), b_imaginary, w_real);
+			float32x4_t a_real = vld1q_f32(real + a);
+			float32x4_t a_imaginary = vld1q_f32(imaginary + a);
+
+			vst1q_f32(real + a, vaddq_f32(a_real, t_real));
+			vst1q_f32(imaginary + a, vaddq_f32(a_imaginary, t_imaginary));
+			vst1q_f32(real + b, vsubq_f32(a_real, t_real));
+			vst1q_f32(imaginary + b, vsubq_f32(a_imaginary, t_imaginary));
+		}
+	}
+}
+#endif
+
+GpFftStageKernel gp_fft_select_kernel(const char** name) {
+	const char* kernel_name = "scalar";
+	GpFftStageKernel kernel = gp_fft_stage_scalar;
+
+#if defined(GP_TAP_SSE2)
+	kernel_name = "sse2";
+	kernel = fft_stage_sse2;
+#elif defined(GP_TAP_NEON)
+	kernel_name = "neon";
+	kernel = fft_stage_neon;
+#endif
+
+	if (name != NULL) *name = kernel_name;
+	return kernel;
+}
+
+void gp_tap_init(struct GpTap* tap) {
+	for (size_t i = 0; i < GP_TAP_FRAMES * GP_TAP_CHANNELS; i++) atomic_init(&tap->frames[i], 0);
+	atomic_init(&tap->reserved, 0);
+	atomic_init(&tap->written, 0);
+	tap->fft_stage = gp_fft_select_kernel(NULL);
+
+	for (size_t half = 1; half < GP_TAP_MAX_FFT_SIZE; half *= 2) {
+		for (size_t k = 0; k < half; k++) {
+			double angle = -M_PI * (double)k / (double)half;
+			tap->twiddle_real[half - 1 + k] = (float)cos(angle);
+			tap->twiddle_imaginary[half - 1 + k] = (float)sin(angle);
+		}
+	}
+}
+
+static void store_samples(_Atomic float* samples, const float* buffer, size_t frames) {
+	for (size_t i = 0; i < frames * GP_TAP_CHANNELS; i++) {
+		atomic_store_explicit(&samples[i], buffer[i], memory_order_relaxed);
+	}
+}
+
+static void load_samples(float* buffer, _Atomic float* samples, size_t frames) {
+	for (size_t i = 0; i < frames * GP_TAP_CHANNELS; i++) {
+		buffer[i] = atomic_load_explicit(&samples[i], memory_order_relaxed);
+	}
+}
+
+void gp_tap_write(struct GpTap* tap, const float* buffer, size_t frames) {
+	size_t written = atomic_load_explicit(&tap->written, memory_order_relaxed);
+
+	if (frames > GP_TAP_FRAMES) {
+		written += frames - GP_TAP_FRAMES;
+		buffer += (frames - GP_TAP_FRAMES) * GP_TAP_CHANNELS;
+		frames = GP_TAP_FRAMES;
+	}
+
+	atomic_store_explicit(&tap->reserved, written + frames, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+
+	size_t offset = written % GP_TAP_FRAMES;
+	size_t head_frames = GP_TAP_FRAMES - offset < frames ? GP_TAP_FRAMES - offset : frames;
+	store_samples(tap->frames + offset * GP_TAP_CHANNELS, buffer, head_frames);
+	store_samples(tap->frames, buffer + head_frames * GP_TAP_CHANNELS, frames - head_frames);
+
+	atomic_store_explicit(&tap->written, written + frames, memory_order_release);
+}
+
+static bool begin_read(struct GpTap* tap, size_t frames_size, size_t* start) {
+	size_t written = atomic_load_explicit(&tap->written, memory_order_acquire);
+	if (written < frames_size) return false;
+
+	*start = written - frames_size;
+	return true;
+}
+
+static bool end_read(struct GpTap* tap, size_t start) {
+	atomic_thread_fence(memory_order_acquire);
+	return atomic_load_explicit(&tap->reserved, memory_order_relaxed) - start <= GP_TAP_FRAMES;
+}
+
+enum GpResult gp_tap_read(struct GpTap* tap, float* frames, size_t frames_size) {
+	if (frames == NULL || frames_size == 0 || frames_size > GP_TAP_FRAMES) return GP_RESULT_ERROR;
+
+	for (size_t attempt = 0; attempt < GP_TAP_READ_ATTEMPTS; attempt++) {
+		size_t start;
+		if (!begin_read(tap, frames_size, &start)) return GP_RESULT_ERROR;
+
+		size_t offset = start % GP_TAP_FRAMES;
+		size_t head_frames = GP_TAP_FRAMES - offset < frames_size ? GP_TAP_FRAMES - offset : frames_size;
+		load_samples(frames, tap->frames + offset * GP_TAP_CHANNELS, head_frames);
+		load_samples(frames + head_frames * GP_TAP_CHANNELS, tap->frames, frames_size - head_frames);
+
+		if (end_read(tap, start)) return GP_RESULT_OK;
+	}
+
+	return GP_RESULT_ERROR;
+}
+
+enum GpResult gp_tap_levels(struct GpTap* tap, size_t frames_size, struct GpLevels* levels) {
+	if (levels == NULL || frames_size == 0 || frames_size > GP_TAP_FRAMES) return GP_RESULT_ERROR;
+
+	for (size_t attempt = 0; attempt < GP_TAP_READ_ATTEMPTS; attempt++) {
+		size_t start;
+		if (!begin_read(tap, frames_size, &start)) return GP_RESULT_ERROR;
+
+		float peaks[GP_TAP_CHANNELS] = {0};
+		double energies[GP_TAP_CHANNELS] = {0};
+		for (size_t i = 0; i < frames_size; i++) {
+			_Atomic float* frame = tap->frames + (start + i) % GP_TAP_FRAMES * GP_TAP_CHANNELS;
+			for (size_t channel = 0; channel < GP_TAP_CHANNELS; channel++) {
+				float sample = fabsf(atomic_load_explicit(&frame[channel], memory_order_relaxed));
+				if (sample > peaks[channel]) peaks[channel] = sample;
+				energies[channel] += (double)sample * sample;
+			}
+		}
+
+		if (!end_read(tap, start)) continue;
+
+		for (size_t channel = 0; channel < GP_TAP_CHANNELS; channel++) {
+			levels->peak[channel] = peaks[channel];
+			levels->rms[channel] = (float)sqrt(energies[channel] / (double)frames_size);
+		}
+
+		return GP_RESULT_OK;
+	}
+
+	return GP_RESULT_ERROR;
+}
+
+static size_t reverse_bits(size_t index, size_t bits) {
+	size_t reversed = 0;
+	for (size_t i = 0; i < bits; i++) {
+		reversed = (reversed << 1) | (index & 1);
+		index >>= 1;
+	}
+
+	return reversed;
+}
+
+enum GpResult gp_tap_spectrum(struct GpTap* tap, float* magnitudes, size_t magnitudes_size) {
+	size_t size = magnitudes_size * 2;
+	if (magnitudes == NULL || magnitudes_size == 0 || size > GP_TAP_MAX_FFT_SIZE
+			|| (size & (size - 1)) != 0) {
+		return GP_RESULT_ERROR;
+	}
+
+	float frames[GP_TAP_MAX_FFT_SIZE * GP_TAP_CHANNELS];
+	if (gp_tap_read(tap, frames, size) != GP_RESULT_OK) return GP_RESULT_ERROR;
+
+	size_t bits = 0;
+	while (((size_t)1 << bits) < size) bits++;
+
+	float real[GP_TAP_MAX_FFT_SIZE];
+	float imaginary[GP_TAP_MAX_FFT_SIZE] = {0};
+	for (size_t i = 0; i < size; i++) {
+		float window = (float)(0.5 - 0.5 * cos(2 * M_PI * (double)i / (double)size));
+		real[reverse_bits(i, bits)] = (frames[i * 2] + frames[i * 2 + 1]) * 0.5f * window;
+	}
+
+	for (size_t half = 1; half < size; half *= 2) {
+		tap->fft_stage(real, imaginary, size, half, tap->twiddle_real + half - 1, tap->twiddle_imaginary + half - 1);
+	}
+
+	float scale = 4.0f / (float)size;
+	for (size_t i = 0; i < magnitudes_size; i++) {
+		magnitudes[i] = sqrtf(real[i] * real[i] + imaginary[i] * imaginary[i]) * scale;
+	}
+
+	return GP_RESULT_OK;
+}
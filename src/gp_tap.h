@@ -0,0 +1,31 @@
+#pragma once
+#include <stdatomic.h>
+#include <stddef.h>
+#include "grass_player.h"
+
+#define GP_TAP_CHANNELS 2
+#define GP_TAP_FRAMES 16384
+#define GP_TAP_MAX_FFT_SIZE 4096
+#define GP_TAP_READ_ATTEMPTS 4
+
+typedef void (* GpFftStageKernel)(float* real, float* imaginary, size_t size, size_t half,
+		const float* twiddle_real, const float* twiddle_imaginary);
+
+struct GpTap {
+  _Atomic float frames[GP_TAP_FRAMES * GP_TAP_CHANNELS];
+  atomic_size_t reserved;
+  atomic_size_t written;
+  GpFftStageKernel fft_stage;
+  float twiddle_real[GP_TAP_MAX_FFT_SIZE - 1];
+  float twiddle_imaginary[GP_TAP_MAX_FFT_SIZE - 1];
+};
+
+void gp_tap_init(struct GpTap* tap);
+void gp_tap_write(struct GpTap* tap, const float* buffer, size_t frames);
+enum GpResult gp_tap_read(struct GpTap* tap, float* frames, size_t frames_size);
+enum GpResult gp_tap_levels(struct GpTap* tap, size_t frames_size, struct GpLevels* levels);
+enum GpResult gp_tap_spectrum(struct GpTap* tap, float* magnitudes, size_t magnitudes_size);
+
+GpFftStageKernel gp_fft_select_kernel(const char** name);
+void gp_fft_stage_scalar(float* real, float* imaginary, size_t size, size_t half,
+		const float* twiddle_real, const float* twiddle_imaginary);
@@ -0,0 +1,88 @@
+#include "gp_wav.h"
+#include <string.h>
+
+#define GP_WAV_FORMAT_IEEE_FLOAT 3
+#define GP_WAV_HEADER_SIZE 58
+#define GP_WAV_MAX_DATA_SIZE (UINT32_MAX - GP_WAV_HEADER_SIZE)
+
+static void put_u16(uint8_t* buffer, uint16_t value) {
+	buffer[0] = (uint8_t)value;
+	buffer[1] = (uint8_t)(value >> 8);
+}
+
+static void put_u32(uint8_t* buffer, uint32_t value) {
+	put_u16(buffer, (uint16_t)value);
+	put_u16(buffer + 2, (uint16_t)(value >> 16));
+}
+
+static enum GpResult write_header(struct GpWavWriter* writer) {
+	uint32_t data_size = writer->data_size > GP_WAV_MAX_DATA_SIZE
+			? GP_WAV_MAX_DATA_SIZE
+			: (uint32_t)writer->data_size;
+	uint16_t block_align = (uint16_t)(writer->channels * sizeof(float));
+	uint8_t header[GP_WAV_HEADER_SIZE] = {0};
+
+	memcpy(header, "RIFF", 4);
+	put_u32(header + 4, GP_WAV_HEADER_SIZE - 8 + data_size);
+	memcpy(header + 8, "WAVE", 4);
+
+	memcpy(header + 12, "fmt ", 4);
+	put_u32(header + 16, 18);
+	put_u16(header + 20, GP_WAV_FORMAT_IEEE_FLOAT);
+	put_u16(header + 22, writer->channels);
+	put_u32(header + 24, writer->sample_rate);
+	put_u32(header + 28, writer->sample_rate * block_align);
+	put_u16(header + 32, block_align);
+	put_u16(header + 34, 8 * sizeof(float));
+	put_u16(header + 36, 0);
+
+	memcpy(header + 38, "fact", 4);
+	put_u32(header + 42, 4);
+	put_u32(header + 46, data_size / block_align);
+
+	memcpy(header + 50, "data", 4);
+	put_u32(header + 54, data_size);
+
+	if (fseek(writer->file, 0, SEEK_SET) != 0) return GP_RESULT_ERROR;
+	if (fwrite(header, 1, sizeof(header), writer->file) != sizeof(header)) return GP_RESULT_ERROR;
+
+	return GP_RESULT_OK;
+}
+
+enum GpResult gp_wav_open(struct GpWavWriter* writer, const char* path, uint32_t sample_rate,
+		uint16_t channels) {
+	writer->file = fopen(path, "wb");
+	if (writer->file == NULL) return GP_RESULT_ERROR;
+
+	writer->sample_rate = sample_rate;
+	writer->channels = channels;
+	writer->data_size = 0;
+
+	if (write_header(writer) != GP_RESULT_OK) {
+		fclose(writer->file);
+		writer->file = NULL;
+		return GP_RESULT_ERROR;
+	}
+
+	return GP_RESULT_OK;
+}
+
+enum GpResult gp_wav_write(struct GpWavWriter* writer, const float* frames, size_t frames_size) {
+	size_t samples_size = frames_size * writer->channels;
+	if (fwrite(frames, sizeof(float), samples_size, writer->file) != samples_size) {
+		return GP_RESULT_ERROR;
+	}
+
+	writer->data_size += samples_size * sizeof(float);
+	return GP_RESULT_OK;
+}
+
+enum GpResult gp_wav_close(struct GpWavWriter* writer) {
+	if (writer->file == NULL) return GP_RESULT_OK;
+
+	enum GpResult result = write_header(writer);
+	if (fclose(writer->file) != 0) result = GP_RESULT_ERROR;
+	writer->file = NULL;
+
+	return result;
+}
@@ -0,0 +1,16 @@
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+#include "grass_player.h"
+
+struct GpWavWriter {
+  FILE* file;
+  uint32_t sample_rate;
+  uint16_t channels;
+  uint64_t data_size;
+};
+
+enum GpResult gp_wav_open(struct GpWavWriter* writer, const char* path, uint32_t sample_rate,
+		uint16_t channels);
+enum GpResult gp_wav_write(struct GpWavWriter* writer, const float* frames, size_t frames_size);
+enum GpResult gp_wav_close(struct GpWavWriter* writer);
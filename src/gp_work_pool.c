@@ -0,0 +1,136 @@
+#include "gp_work_pool.h"
+#include <stdbool.h>
+#include <stdlib.h>
+#include <threads.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+struct GpWorker {
+  struct GpWorkRange* ranges;
+  size_t threads_size;
+  size_t worker_index;
+  GpWorkFunction function;
+  void* user;
+};
+
+static uint64_t pack_range(uint32_t begin, uint32_t end) {
+	return (uint64_t)begin << 32 | end;
+}
+
+static uint32_t range_begin(uint64_t range) {
+	return (uint32_t)(range >> 32);
+}
+
+static uint32_t range_end(uint64_t range) {
+	return (uint32_t)range;
+}
+
+static bool take_item(struct GpWorkRange* own, uint32_t* item_index) {
+	uint64_t range = atomic_load_explicit(&own->range, memory_order_acquire);
+
+	while (range_begin(range) < range_end(range)) {
+		uint64_t taken = pack_range(range_begin(range) + 1, range_end(range));
+		if (atomic_compare_exchange_weak_explicit(&own->range, &range, taken,
+				memory_order_acq_rel, memory_order_acquire)) {
+			*item_index = range_begin(range);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static bool steal_range(struct GpWorker* worker) {
+	for (size_t i = 1; i < worker->threads_size; i++) {
+		struct GpWorkRange* victim = &worker->ranges[(worker->worker_index + i) % worker->threads_size];
+		uint64_t range = atomic_load_explicit(&victim->range, memory_order_acquire);
+
+		while (range_begin(range) < range_end(range)) {
+			uint32_t begin = range_begin(range);
+			uint32_t end = range_end(range);
+			uint32_t middle = begin + (end - begin) / 2;
+
+			if (atomic_compare_exchange_weak_explicit(&victim->range, &range, pack_range(begin, middle),
+					memory_order_acq_rel, memory_order_acquire)) {
+				atomic_store_explicit(&worker->ranges[worker->worker_index].range, pack_range(middle, end),
+						memory_order_release);
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+static int run_worker(void* arg) {
+	struct GpWorker* worker = arg;
+	struct GpWorkRange* own = &worker->ranges[worker->worker_index];
+	uint32_t item_index;
+
+	do {
+		while (take_item(own, &item_index)) {
+			worker->function(item_index, worker->worker_index, worker->user);
+		}
+	} while (steal_range(worker));
+
+	return 0;
+}
+
+size_t gp_work_pool_default_threads(void) {
+#ifdef _WIN32
+	SYSTEM_INFO system_info;
+	GetSystemInfo(&system_info);
+	size_t threads_size = system_info.dwNumberOfProcessors;
+#else
+	long processors = sysconf(_SC_NPROCESSORS_ONLN);
+	size_t threads_size = processors > 0 ? (size_t)processors : 1;
+#endif
+	return threads_size < GP_WORK_POOL_MAX_THREADS ? threads_size : GP_WORK_POOL_MAX_THREADS;
+}
+
+enum GpResult gp_work_pool_run(size_t threads_size, size_t items_size, GpWorkFunction function, void* user) {
+	if (function == NULL || items_size > UINT32_MAX) return GP_RESULT_ERROR;
+	if (items_size == 0) return GP_RESULT_OK;
+
+	if (threads_size == 0) threads_size = gp_work_pool_default_threads();
+	if (threads_size > GP_WORK_POOL_MAX_THREADS) threads_size = GP_WORK_POOL_MAX_THREADS;
+	if (threads_size > items_size) threads_size = items_size;
+
+	struct GpWorkRange* ranges = malloc(threads_size * sizeof(struct GpWorkRange));
+	struct GpWorker* workers = malloc(threads_size * sizeof(struct GpWorker));
+	thrd_t* threads = malloc(threads_size * sizeof(thrd_t));
+
+	if (ranges == NULL || workers == NULL || threads == NULL) {
+		free(ranges);
+		free(workers);
+		free(threads);
+		return GP_RESULT_ERROR;
+	}
+
+	for (size_t i = 0; i < threads_size; i++) {
+		uint32_t begin = (uint32_t)(items_size * i / threads_size);
+		uint32_t end = (uint32_t)(items_size * (i + 1) / threads_size);
+		atomic_init(&ranges[i].range, pack_range(begin, end));
+		workers[i] = (struct GpWorker){ranges, threads_size, i, function, user};
+	}
+
+	size_t started_size = 1;
+	for (; started_size < threads_size; started_size++) {
+		if (thrd_create(&threads[started_size], run_worker, &workers[started_size]) != thrd_success) break;
+	}
+
+	run_worker(&workers[0]);
+
+	for (size_t i = 1; i < started_size; i++) thrd_join(threads[i], NULL);
+
+	for (size_t i = started_size; i < threads_size; i++) run_worker(&workers[i]);
+
+	free(ranges);
+	free(workers);
+	free(threads);
+
+	return GP_RESULT_OK;
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "grass_player.h"
+
+#define GP_WORK_POOL_MAX_THREADS 64
+#define GP_WORK_POOL_CACHE_LINE_SIZE 64
+
+typedef void (* GpWorkFunction)(size_t item_index, size_t worker_index, void* user);
+
+struct GpWorkRange {
+  _Atomic uint64_t range;
+  uint8_t padding[GP_WORK_POOL_CACHE_LINE_SIZE - sizeof(uint64_t)];
+};
+
+size_t gp_work_pool_default_threads(void);
+enum GpResult gp_work_pool_run(size_t threads_size, size_t items_size, GpWorkFunction function, void* user);
@@ -0,0 +1,114 @@
+#include "gp_zone.h"
+#include <stdlib.h>
+#include <string.h>
+#include "bass.h"
+#include "bassmix.h"
+#include "gp_audio_output.h"
+
+void gp_zone_delay(float* buffer, size_t samples, float* delay, size_t delay_size, size_t* delay_position) {
+	if (delay_size == 0) return;
+
+	size_t position = *delay_position;
+	for (size_t i = 0; i < samples; i++) {
+		float sample = delay[position];
+		delay[position] = buffer[i];
+		buffer[i] = sample;
+		if (++position == delay_size) position = 0;
+	}
+
+	*delay_position = position;
+}
+
+static void CALLBACK handle_zone_dsp(HDSP dsp, DWORD channel, void* buffer, DWORD length, void* user) {
+	(void)dsp;
+	(void)channel;
+
+	struct GpZone* zone = user;
+	gp_zone_delay(buffer, length / sizeof(float), zone->delay, zone->delay_size, &zone->delay_position);
+}
+
+struct GpZone* gp_zone_open(uint32_t mixer_stream_handle, int device) {
+	struct GpZone* zone = calloc(1, sizeof(struct GpZone));
+	if (zone == NULL) return NULL;
+
+	if (gp_audio_output_acquire_device(device, &zone->device, &zone->device_latency_ms) != GP_RESULT_OK) {
+		free(zone);
+		return NULL;
+	}
+
+	BASS_CHANNELINFO info;
+	zone->stream_handle = BASS_Split_StreamCreate(mixer_stream_handle, 0, NULL);
+	if (zone->stream_handle == 0 || !BASS_ChannelSetDevice(zone->stream_handle, zone->device)
+			|| !BASS_ChannelGetInfo(zone->stream_handle, &info)
+			|| BASS_ChannelSetDSP(zone->stream_handle, &handle_zone_dsp, zone, 0) == 0) {
+		gp_zone_close(zone);
+		return NULL;
+	}
+	zone->sample_rate = info.freq;
+
+	return zone;
+}
+
+void gp_zone_close(struct GpZone* zone) {
+	if (zone == NULL) return;
+
+	if (zone->stream_handle != 0) BASS_StreamFree(zone->stream_handle);
+	gp_audio_output_release_device(zone->device);
+	free(zone->delay);
+	free(zone);
+}
+
+void gp_zone_set_gain(struct GpZone* zone, float gain) {
+	BASS_ChannelSetAttribute(zone->stream_handle, BASS_ATTRIB_VOL, gain > 0 ? gain : 0);
+}
+
+enum GpResult gp_zone_set_latency_offset(struct GpZone* zone, uint32_t latency_offset_ms) {
+	size_t delay_size = (size_t)zone->sample_rate * latency_offset_ms / 1000 * GP_ZONE_CHANNELS;
+	float* delay = NULL;
+
+	if (delay_size > 0) {
+		delay = calloc(delay_size, sizeof(float));
+		if (delay == NULL) return GP_RESULT_ERROR;
+	}
+
+	BASS_ChannelLock(zone->stream_handle, TRUE);
+	float* previous_delay = zone->delay;
+	zone->delay = delay;
+	zone->delay_size = delay_size;
+	zone->delay_position = 0;
+	BASS_ChannelLock(zone->stream_handle, FALSE);
+
+	free(previous_delay);
+
+	return GP_RESULT_OK;
+}
+
+void gp_zone_play(struct GpZone* zone) {
+	BASS_ChannelPlay(zone->stream_handle, FALSE);
+}
+
+void gp_zone_pause(struct GpZone* zone) {
+	BASS_ChannelPause(zone->stream_handle);
+}
+
+void gp_zone_stop(struct GpZone* zone) {
+	BASS_ChannelStop(zone->stream_handle);
+	BASS_Split_StreamReset(zone->stream_handle);
+
+	BASS_ChannelLock(zone->stream_handle, TRUE);
+	if (zone->delay != NULL) memset(zone->delay, 0, zone->delay_size * sizeof(float));
+	zone->delay_position = 0;
+	BASS_ChannelLock(zone->stream_handle, FALSE);
+}
+
+uint32_t gp_zone_get_delay(const struct GpZone* zone) {
+	uint32_t delay = (uint32_t)(zone->delay_size * sizeof(float));
+
+	uint32_t split_buffered = BASS_Split_StreamGetAvailable(zone->stream_handle);
+	if (split_buffered != (uint32_t)-1) delay += split_buffered;
+
+	uint32_t buffered = BASS_ChannelGetData(zone->stream_handle, NULL, BASS_DATA_AVAILABLE);
+	if (buffered != (uint32_t)-1) delay += buffered;
+
+	return delay + (uint32_t)BASS_ChannelSeconds2Bytes(zone->stream_handle, zone->device_latency_ms / 1000.0);
+}
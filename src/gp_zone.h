@@ -0,0 +1,27 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "grass_player.h"
+
+#define GP_MAX_ZONES 8
+#define GP_ZONE_CHANNELS 2
+
+struct GpZone {
+  uint32_t stream_handle;
+  int device;
+  uint32_t sample_rate;
+  uint32_t device_latency_ms;
+  float* delay;
+  size_t delay_size;
+  size_t delay_position;
+};
+
+struct GpZone* gp_zone_open(uint32_t mixer_stream_handle, int device);
+void gp_zone_close(struct GpZone* zone);
+void gp_zone_set_gain(struct GpZone* zone, float gain);
+enum GpResult gp_zone_set_latency_offset(struct GpZone* zone, uint32_t latency_offset_ms);
+void gp_zone_play(struct GpZone* zone);
+void gp_zone_pause(struct GpZone* zone);
+void gp_zone_stop(struct GpZone* zone);
+uint32_t gp_zone_get_delay(const struct GpZone* zone);
+void gp_zone_delay(float* buffer, size_t samples, float* delay, size_t delay_size, size_t* delay_position);
@@ -0,0 +1,619 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "grass_player.h"
+#include "gp_clock.h"
+#include "bass.h"
+#include "gp_gain.h"
+#include "gp_loudness.h"
+#include "gp_seek_index.h"
+#include "gp_source.h"
+#include "gp_tap.h"
+#include "gp_source_list.h"
+#include "gp_work_pool.h"
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <unistd.h>
+#endif
+
+#define CONCAT(a, b) (a b)
+#define SAMPLE_RATE GP_SAMPLE_RATE_44100
+#define BLOCK_FRAMES 4096
+#define LATENCY_RUNS 200
+
+static const char* default_files[] = {
+		CONCAT(PROJECT_TEST_DIR, "/sample-files/01_Ghosts_I.flac"),
+		CONCAT(PROJECT_TEST_DIR, "/sample-files/24_Ghosts_III.flac"),
+		CONCAT(PROJECT_TEST_DIR, "/sample-files/25_Ghosts_III.flac")
+};
+
+static const size_t set_sources_sizes[] = {1000, 100000, 1000000};
+static const size_t source_list_size = 500000;
+
+static float block[BLOCK_FRAMES * 2];
+
+static int compare_doubles(const void* a, const void* b) {
+	double x = *(const double*)a;
+	double y = *(const double*)b;
+	return (x > y) - (x < y);
+}
+
+static double percentile(double* samples, size_t size, double p) {
+	qsort(samples, size, sizeof(double), compare_doubles);
+	size_t index = (size_t)(p * (double)(size - 1) + 0.5);
+	return samples[index];
+}
+
+static const char* file_format(const char* path) {
+	const char* extension = strrchr(path, '.');
+	return extension == NULL ? "unknown" : extension + 1;
+}
+
+static size_t resident_bytes(void) {
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+	return counters.WorkingSetSize;
+#else
+	size_t total_pages = 0;
+	size_t resident_pages = 0;
+	FILE* statm = fopen("/proc/self/statm", "r");
+	if (statm == NULL) return 0;
+	if (fscanf(statm, "%zu %zu", &total_pages, &resident_pages) != 2) resident_pages = 0;
+	fclose(statm);
+	return resident_pages * (size_t)sysconf(_SC_PAGESIZE);
+#endif
+}
+
+static void print_latency(const char* name, double* samples, size_t size) {
+	printf("  \"%s\": {\"runs\": %zu, \"p50_ms\": %.4f, \"p99_ms\": %.4f}",
+			name, size,
+			percentile(samples, size, 0.50) * 1e3,
+			percentile(samples, size, 0.99) * 1e3);
+}
+
+static void bench_decode(const char** files, size_t files_size) {
+	static const enum GpSourceMode source_modes[] = {GP_SOURCE_MODE_FILE, GP_SOURCE_MODE_MAPPED};
+	static const char* source_mode_names[] = {"file", "mapped"};
+
+	printf("  \"decode\": [");
+
+	for (size_t mode = 0; mode < sizeof(source_modes) / sizeof(source_modes[0]); mode++) {
+		gp_set_source_mode(source_modes[mode]);
+
+		for (size_t i = 0; i < files_size; i++) {
+			gp_set_sources(&files[i], 1);
+			gp_play();
+
+			size_t frames_size = 0;
+			size_t rendered_size;
+			double start = gp_clock_now();
+			while ((rendered_size = gp_render(block, BLOCK_FRAMES)) > 0) frames_size += rendered_size;
+			double elapsed = gp_clock_now() - start;
+
+			printf("%s\n    {\"path\": \"%s\", \"format\": \"%s\", \"source_mode\": \"%s\", "
+					"\"frames\": %zu, \"seconds\": %.6f, \"frames_per_second\": %.0f, "
+					"\"realtime_factor\": %.1f}",
+					mode == 0 && i == 0 ? "" : ",", files[i], file_format(files[i]),
+					source_mode_names[mode], frames_size, elapsed,
+					frames_size / elapsed, frames_size / elapsed / SAMPLE_RATE);
+		}
+	}
+
+	gp_set_source_mode(GP_SOURCE_MODE_FILE);
+	printf("\n  ],\n");
+}
+
+static void bench_seek(const char** files) {
+	double samples[LATENCY_RUNS];
+
+	gp_set_sources(files, 1);
+	gp_play();
+	gp_flush();
+	double duration = gp_get_source_duration();
+
+	srand(1);
+	for (size_t i = 0; i < LATENCY_RUNS; i++) {
+		double position = duration * rand() / ((double)RAND_MAX + 1);
+
+		double start = gp_clock_now();
+		gp_seek(position);
+		gp_render(block, BLOCK_FRAMES);
+		samples[i] = gp_clock_now() - start;
+	}
+
+	print_latency("seek", samples, LATENCY_RUNS);
+	printf(",\n");
+}
+
+static void time_stream_seeks(uint32_t stream_handle, double* samples) {
+	double duration = BASS_ChannelBytes2Seconds(stream_handle, BASS_ChannelGetLength(stream_handle, BASS_POS_BYTE));
+
+	srand(1);
+	for (size_t i = 0; i < LATENCY_RUNS; i++) {
+		double position = duration * rand() / ((double)RAND_MAX + 1);
+
+		double start = gp_clock_now();
+		BASS_ChannelSetPosition(stream_handle, BASS_ChannelSeconds2Bytes(stream_handle, position), BASS_POS_BYTE);
+		BASS_ChannelGetData(stream_handle, block, sizeof(block) | BASS_DATA_FLOAT);
+		samples[i] = gp_clock_now() - start;
+	}
+}
+
+static uint32_t create_index_stream(struct GpMetadataCache* cache, const struct GpSource* source) {
+	struct GpFileMap* file_map = gp_file_map_open(source, GP_FILE_MAP_ACCESS_SEQUENTIAL);
+	if (file_map == NULL) return 0;
+
+	struct GpSeekIndex* index = gp_seek_index_open(cache, source, file_map);
+	if (index == NULL) {
+		gp_file_map_close(file_map);
+		return 0;
+	}
+
+	return gp_seek_index_create_stream(index, BASS_STREAM_DECODE | BASS_SAMPLE_FLOAT);
+}
+
+static void bench_seek_index(const char* file) {
+	double samples[LATENCY_RUNS];
+	struct GpSource* source = gp_new_source(file);
+	struct GpMetadataCache* cache = gp_new_metadata_cache();
+	if (source == NULL || cache == NULL) {
+		gp_free_source(source);
+		gp_free_metadata_cache(cache);
+		return;
+	}
+
+	uint32_t stream_handle = gp_source_create_stream(source, BASS_STREAM_DECODE | BASS_SAMPLE_FLOAT);
+	time_stream_seeks(stream_handle, samples);
+	BASS_StreamFree(stream_handle);
+	print_latency("seek_without_index", samples, LATENCY_RUNS);
+	printf(",\n");
+
+	stream_handle = create_index_stream(cache, source);
+	double start = gp_clock_now();
+	while (BASS_ChannelGetData(stream_handle, block, sizeof(block) | BASS_DATA_FLOAT) != (DWORD)-1) continue;
+	double index_time = gp_clock_now() - start;
+	BASS_StreamFree(stream_handle);
+
+	stream_handle = create_index_stream(cache, source);
+	time_stream_seeks(stream_handle, samples);
+	BASS_StreamFree(stream_handle);
+	print_latency("seek_with_index", samples, LATENCY_RUNS);
+	printf(",\n  \"seek_index_decode_seconds\": %.6f,\n", index_time);
+
+	gp_free_metadata_cache(cache);
+	gp_free_source(source);
+}
+
+static void bench_skip_to(const char** files, size_t files_size) {
+	double samples[LATENCY_RUNS];
+
+	gp_set_sources(files, files_size);
+	gp_play();
+
+	srand(1);
+	for (size_t i = 0; i < LATENCY_RUNS; i++) {
+		size_t source_index = (size_t)rand() % files_size;
+
+		double start = gp_clock_now();
+		gp_skip_to(source_index);
+		gp_render(block, BLOCK_FRAMES);
+		samples[i] = gp_clock_now() - start;
+	}
+
+	print_latency("skip_to", samples, LATENCY_RUNS);
+	printf(",\n");
+}
+
+static void bench_set_sources(const char* file) {
+	size_t sizes_size = sizeof(set_sources_sizes) / sizeof(set_sources_sizes[0]);
+	printf("  \"set_sources\": [");
+
+	for (size_t i = 0; i < sizes_size; i++) {
+		size_t size = set_sources_sizes[i];
+		const char** sources = malloc(sizeof(const char*) * size);
+		if (sources == NULL) break;
+		for (size_t j = 0; j < size; j++) sources[j] = file;
+
+		double start = gp_clock_now();
+		gp_set_sources(sources, size);
+		gp_flush();
+		double elapsed = gp_clock_now() - start;
+
+		printf("%s\n    {\"entries\": %zu, \"seconds\": %.6f}", i == 0 ? "" : ",", size, elapsed);
+		free(sources);
+	}
+
+	printf("\n  ],\n");
+}
+
+static void bench_source_list(const char* file) {
+	const char** paths = malloc(sizeof(const char*) * source_list_size);
+	struct GpSource** legacy_list = malloc(sizeof(struct GpSource*) * source_list_size);
+	if (paths == NULL || legacy_list == NULL) {
+		free(paths);
+		free(legacy_list);
+		return;
+	}
+	for (size_t i = 0; i < source_list_size; i++) paths[i] = file;
+
+	size_t rss_before = resident_bytes();
+	double start = gp_clock_now();
+	struct GpSourceList* source_list = gp_new_source_list(paths, source_list_size);
+	double build_time = gp_clock_now() - start;
+	size_t rss = resident_bytes() - rss_before;
+	start = gp_clock_now();
+	gp_free_source_list(source_list);
+	double free_time = gp_clock_now() - start;
+
+	printf("  \"source_list\": {\"entries\": %zu,\n", source_list_size);
+	printf("    \"arena\": {\"build_seconds\": %.6f, \"free_seconds\": %.6f, \"rss_bytes\": %zu},\n",
+			build_time, free_time, rss);
+
+	rss_before = resident_bytes();
+	start = gp_clock_now();
+	for (size_t i = 0; i < source_list_size; i++) legacy_list[i] = gp_new_source(paths[i]);
+	build_time = gp_clock_now() - start;
+	rss = resident_bytes() - rss_before;
+	start = gp_clock_now();
+	for (size_t i = 0; i < source_list_size; i++) gp_free_source(legacy_list[i]);
+	free_time = gp_clock_now() - start;
+
+	printf("    \"per_source\": {\"build_seconds\": %.6f, \"free_seconds\": %.6f, \"rss_bytes\": %zu}\n",
+			build_time, free_time, rss);
+	printf("  },\n");
+
+	free(legacy_list);
+	free(paths);
+}
+
+#define METADATA_CACHE_PATH "gp_bench_metadata.cache"
+#define METADATA_LOOKUPS 100000
+
+static double time_source_info(size_t sources_size, size_t lookups) {
+	struct GpSourceInfo info;
+	double start = gp_clock_now();
+	for (size_t i = 0; i < lookups; i++) gp_get_source_info(i % sources_size, &info);
+	return (gp_clock_now() - start) / (double)lookups;
+}
+
+static void bench_metadata_cache(const char** files, size_t files_size) {
+	remove(METADATA_CACHE_PATH);
+	gp_open_metadata_cache(METADATA_CACHE_PATH);
+	gp_set_sources(files, files_size);
+	gp_flush();
+
+	double probe_time = time_source_info(files_size, files_size);
+	double memory_time = time_source_info(files_size, METADATA_LOOKUPS);
+	gp_save_metadata_cache();
+	double mapped_time = time_source_info(files_size, METADATA_LOOKUPS);
+
+	printf("  \"metadata_cache\": {\"probe_ms\": %.4f, \"memory_lookup_us\": %.4f, \"mapped_lookup_us\": %.4f},\n",
+			probe_time * 1e3, memory_time * 1e6, mapped_time * 1e6);
+
+	remove(METADATA_CACHE_PATH);
+}
+
+#define SCAN_FILES 2000
+
+static void count_scan_results(const struct GpScanResult* results, size_t results_size, void* user) {
+	size_t* valid_size = user;
+	for (size_t i = 0; i < results_size; i++) *valid_size += results[i].valid;
+}
+
+static void bench_scan(const char** files, size_t files_size) {
+	const char** paths = malloc(SCAN_FILES * sizeof(const char*));
+	if (paths == NULL) {
+		fprintf(stderr, "[ERROR]: could not allocate the scan paths\n");
+		printf("  \"scan\": [],\n");
+		return;
+	}
+	for (size_t i = 0; i < SCAN_FILES; i++) paths[i] = files[i % files_size];
+
+	size_t max_threads = gp_work_pool_default_threads();
+
+	printf("  \"scan\": [");
+
+	for (size_t threads_size = 1;; threads_size *= 2) {
+		if (threads_size > max_threads) threads_size = max_threads;
+
+		size_t valid_size = 0;
+		double start = gp_clock_now();
+		gp_scan(paths, SCAN_FILES, threads_size, count_scan_results, &valid_size);
+		double elapsed = gp_clock_now() - start;
+
+		printf("%s\n    {\"threads\": %zu, \"files\": %d, \"valid\": %zu, \"files_per_second\": %.1f}",
+				threads_size > 1 ? "," : "", threads_size, SCAN_FILES, valid_size, (double)SCAN_FILES / elapsed);
+
+		if (threads_size == max_threads) break;
+	}
+
+	printf("\n  ],\n");
+
+	free(paths);
+}
+
+#define GAIN_FRAMES 1024
+#define GAIN_RUNS 20000
+
+static double time_gain_kernel(GpGainKernel kernel, const float* source, float* destination) {
+	double start = gp_clock_now();
+	for (size_t i = 0; i < GAIN_RUNS; i++) kernel(source, destination, GAIN_FRAMES, 0.5f, 1e-5f);
+
+	return (double)GAIN_FRAMES * GAIN_RUNS / (gp_clock_now() - start);
+}
+
+static void bench_gain(void) {
+	static float source[GAIN_FRAMES * 2];
+	static float destination[GAIN_FRAMES * 2];
+	srand(1);
+	for (size_t i = 0; i < GAIN_FRAMES * 2; i++) source[i] = (float)rand() / RAND_MAX * 2 - 1;
+
+	const char* kernel_name;
+	GpGainKernel kernel = gp_gain_select_kernel(&kernel_name);
+	double scalar_rate = time_gain_kernel(gp_gain_apply_scalar, source, destination);
+	double kernel_rate = time_gain_kernel(kernel, source, destination);
+
+	static struct GpGainStage stage;
+	gp_gain_stage_init(&stage, SAMPLE_RATE);
+	gp_gain_stage_set_volume(&stage, 0.5f);
+	double start = gp_clock_now();
+	for (size_t i = 0; i < GAIN_RUNS; i++) gp_gain_stage_process(&stage, destination, GAIN_FRAMES);
+	double stage_rate = (double)GAIN_FRAMES * GAIN_RUNS / (gp_clock_now() - start);
+
+	printf("  \"gain\": {\"kernel\": \"%s\", \"scalar_frames_per_second\": %.0f, "
+			"\"kernel_frames_per_second\": %.0f, \"speedup\": %.2f, \"stage_frames_per_second\": %.0f},\n",
+			kernel_name, scalar_rate, kernel_rate, kernel_rate / scalar_rate, stage_rate);
+}
+
+#define LOUDNESS_FRAMES 4096
+#define LOUDNESS_RUNS 2000
+
+static double time_k_weighting(GpKWeightingKernel kernel, const struct GpKWeighting* weighting, const float* samples) {
+	double states[4 * 2] = {0};
+	double energies[2];
+	double start = gp_clock_now();
+	for (size_t i = 0; i < LOUDNESS_RUNS; i++) kernel(weighting, states, samples, LOUDNESS_FRAMES, 2, energies);
+
+	return (double)LOUDNESS_FRAMES * LOUDNESS_RUNS / (gp_clock_now() - start);
+}
+
+static double time_true_peak(GpTruePeakKernel kernel, const float* samples, const float* coefficients) {
+	double start = gp_clock_now();
+	for (size_t i = 0; i < LOUDNESS_RUNS; i++) kernel(samples, LOUDNESS_FRAMES, coefficients);
+
+	return (double)LOUDNESS_FRAMES * LOUDNESS_RUNS / (gp_clock_now() - start);
+}
+
+static void analyze_file(size_t item_index, size_t worker_index, void* user) {
+	(void)worker_index;
+	struct GpSource** sources = user;
+	struct GpLoudnessInfo loudness;
+	if (sources[item_index] != NULL) gp_loudness_analyze(sources[item_index], &loudness);
+}
+
+static void bench_loudness(const char** files, size_t files_size) {
+	static float samples[(GP_TRUE_PEAK_TAPS - 1 + LOUDNESS_FRAMES) * 2];
+	srand(1);
+	for (size_t i = 0; i < sizeof(samples) / sizeof(samples[0]); i++) samples[i] = (float)rand() / RAND_MAX * 2 - 1;
+
+	struct GpKWeighting weighting;
+	gp_k_weighting_init(&weighting, SAMPLE_RATE);
+	float coefficients[GP_TRUE_PEAK_TAPS * GP_TRUE_PEAK_PHASES];
+	gp_true_peak_init(coefficients);
+
+	const char* kernel_name;
+	GpKWeightingKernel k_weighting;
+	GpTruePeakKernel true_peak;
+	gp_loudness_select_kernels(&k_weighting, &true_peak, &kernel_name);
+
+	double scalar_rate = time_k_weighting(gp_k_weighting_scalar, &weighting, samples);
+	double kernel_rate = time_k_weighting(k_weighting, &weighting, samples);
+	double scalar_peak_rate = time_true_peak(gp_true_peak_scalar, samples, coefficients);
+	double kernel_peak_rate = time_true_peak(true_peak, samples, coefficients);
+
+	printf("  \"loudness\": {\"kernel\": \"%s\",\n", kernel_name);
+	printf("    \"k_weighting\": {\"scalar_frames_per_second\": %.0f, \"kernel_frames_per_second\": %.0f, "
+			"\"speedup\": %.2f},\n", scalar_rate, kernel_rate, kernel_rate / scalar_rate);
+	printf("    \"true_peak\": {\"scalar_samples_per_second\": %.0f, \"kernel_samples_per_second\": %.0f, "
+			"\"speedup\": %.2f},\n", scalar_peak_rate, kernel_peak_rate, kernel_peak_rate / scalar_peak_rate);
+
+	struct GpSource** sources = malloc(files_size * sizeof(struct GpSource*));
+	for (size_t i = 0; i < files_size; i++) sources[i] = gp_new_source(files[i]);
+
+	size_t max_threads = gp_work_pool_default_threads();
+
+	printf("    \"analysis\": [");
+
+	for (size_t threads_size = 1;; threads_size *= 2) {
+		if (threads_size > max_threads) threads_size = max_threads;
+
+		double start = gp_clock_now();
+		gp_work_pool_run(threads_size, files_size, analyze_file, sources);
+		double elapsed = gp_clock_now() - start;
+
+		printf("%s\n      {\"threads\": %zu, \"files\": %zu, \"files_per_second\": %.2f}",
+				threads_size > 1 ? "," : "", threads_size, files_size, (double)files_size / elapsed);
+
+		if (threads_size == max_threads) break;
+	}
+
+	printf("\n    ]\n  },\n");
+
+	for (size_t i = 0; i < files_size; i++) gp_free_source(sources[i]);
+	free(sources);
+}
+
+#define TAP_RUNS 2000
+
+static double time_spectrum(struct GpTap* tap, GpFftStageKernel kernel) {
+	static float magnitudes[GP_TAP_MAX_FFT_SIZE / 2];
+	tap->fft_stage = kernel;
+	double start = gp_clock_now();
+	for (size_t i = 0; i < TAP_RUNS; i++) gp_tap_spectrum(tap, magnitudes, GP_TAP_MAX_FFT_SIZE / 2);
+
+	return (gp_clock_now() - start) / TAP_RUNS;
+}
+
+static void bench_tap(void) {
+	static struct GpTap tap;
+	static float frames[GP_TAP_FRAMES * GP_TAP_CHANNELS];
+	gp_tap_init(&tap);
+	srand(1);
+	for (size_t i = 0; i < GP_TAP_FRAMES * GP_TAP_CHANNELS; i++) frames[i] = (float)rand() / RAND_MAX * 2 - 1;
+
+	double start = gp_clock_now();
+	for (size_t i = 0; i < TAP_RUNS; i++) gp_tap_write(&tap, frames, BLOCK_FRAMES);
+	double write_time = (gp_clock_now() - start) / TAP_RUNS;
+
+	const char* kernel_name;
+	GpFftStageKernel kernel = gp_fft_select_kernel(&kernel_name);
+	double scalar_time = time_spectrum(&tap, gp_fft_stage_scalar);
+	double kernel_time = time_spectrum(&tap, kernel);
+
+	printf("  \"tap\": {\"kernel\": \"%s\", \"write_block_us\": %.3f, \"fft_size\": %d, "
+			"\"scalar_spectrum_us\": %.3f, \"kernel_spectrum_us\": %.3f, \"speedup\": %.2f},\n",
+			kernel_name, write_time * 1e6, GP_TAP_MAX_FFT_SIZE, scalar_time * 1e6, kernel_time * 1e6,
+			scalar_time / kernel_time);
+}
+
+#define PLAYER_RENDER_SECONDS 10
+
+static void render_player(size_t item_index, size_t worker_index, void* user) {
+	(void)worker_index;
+	struct GpPlayer** players = user;
+	float buffer[BLOCK_FRAMES * 2];
+	for (size_t i = 0; i < PLAYER_RENDER_SECONDS * SAMPLE_RATE / BLOCK_FRAMES; i++) {
+		gp_player_render(players[item_index], buffer, BLOCK_FRAMES);
+	}
+}
+
+static void bench_players(const char** files, size_t files_size) {
+	struct GpInitOptions options = {SAMPLE_RATE, GP_OUTPUT_MODE_RENDER, GP_LATENCY_PROFILE_BALANCED};
+	struct GpPlayer* players[GP_WORK_POOL_MAX_THREADS];
+	size_t max_threads = gp_work_pool_default_threads();
+
+	printf("  \"players\": [");
+
+	for (size_t players_size = 1;; players_size *= 2) {
+		if (players_size > max_threads) players_size = max_threads;
+
+		for (size_t i = 0; i < players_size; i++) {
+			players[i] = gp_player_create(&options);
+			gp_player_set_position_interval(players[i], 0);
+			gp_player_set_sources(players[i], files + i % files_size, 1);
+			gp_player_play(players[i]);
+		}
+
+		double start = gp_clock_now();
+		gp_work_pool_run(players_size, players_size, render_player, players);
+		double elapsed = gp_clock_now() - start;
+
+		for (size_t i = 0; i < players_size; i++) gp_player_destroy(players[i]);
+
+		printf("%s\n    {\"players\": %zu, \"realtime_factor\": %.1f}", players_size > 1 ? "," : "",
+				players_size, (double)(players_size * PLAYER_RENDER_SECONDS) / elapsed);
+
+		if (players_size == max_threads) break;
+	}
+
+	printf("\n  ],\n");
+}
+
+static void bench_handover(const char** files, size_t files_size) {
+	struct GpHandoverStats stats = {0};
+
+	if (files_size > 1) {
+		gp_set_sources(files, 2);
+		gp_play();
+		gp_flush();
+		gp_seek(gp_get_source_duration() - 1);
+		for (size_t i = 0; i < 2 * SAMPLE_RATE / BLOCK_FRAMES; i++) gp_render(block, BLOCK_FRAMES);
+		gp_get_handover_stats(&stats);
+	}
+
+	printf("  \"handover\": {\"seconds\": %.9f, \"preloaded\": %s},\n", stats.seconds,
+			stats.preloaded ? "true" : "false");
+}
+
+#define COLD_START_RUNS 50
+
+static void bench_cold_start(const char* file) {
+	struct GpInitOptions options = {SAMPLE_RATE, GP_OUTPUT_MODE_RENDER, GP_LATENCY_PROFILE_BALANCED};
+	double init_samples[COLD_START_RUNS];
+	double close_samples[COLD_START_RUNS];
+	double first_audio_samples[COLD_START_RUNS];
+	struct GpInitStats totals = {0};
+
+	for (size_t i = 0; i < COLD_START_RUNS; i++) {
+		double start = gp_clock_now();
+		struct GpPlayer* player = gp_player_create(&options);
+		init_samples[i] = gp_clock_now() - start;
+		if (player == NULL) {
+			fprintf(stderr, "[ERROR]: could not create a player for cold start run %zu\n", i);
+			printf("  \"cold_start\": null\n");
+			return;
+		}
+
+		gp_player_set_sources(player, &file, 1);
+		gp_player_play(player);
+		gp_player_flush(player);
+		gp_player_render(player, block, BLOCK_FRAMES);
+
+		struct GpInitStats stats;
+		gp_player_get_init_stats(player, &stats);
+		totals.plugin_load_seconds += stats.plugin_load_seconds;
+		totals.device_init_seconds += stats.device_init_seconds;
+		totals.mixer_create_seconds += stats.mixer_create_seconds;
+		totals.sync_setup_seconds += stats.sync_setup_seconds;
+		first_audio_samples[i] = stats.first_audio_seconds;
+
+		start = gp_clock_now();
+		gp_player_destroy(player);
+		close_samples[i] = gp_clock_now() - start;
+	}
+
+	printf("  \"cold_start\": {\n  ");
+	print_latency("init", init_samples, COLD_START_RUNS);
+	printf(",\n  ");
+	print_latency("first_audio", first_audio_samples, COLD_START_RUNS);
+	printf(",\n  ");
+	print_latency("close", close_samples, COLD_START_RUNS);
+	printf(",\n    \"phases_ms\": {\"plugin_load\": %.4f, \"device_init\": %.4f, \"mixer_create\": %.4f, "
+			"\"sync_setup\": %.4f}\n  }\n", totals.plugin_load_seconds * 1e3 / COLD_START_RUNS,
+			totals.device_init_seconds * 1e3 / COLD_START_RUNS, totals.mixer_create_seconds * 1e3 / COLD_START_RUNS,
+			totals.sync_setup_seconds * 1e3 / COLD_START_RUNS);
+}
+
+int main(int argc, const char** argv) {
+	const char** files = argc > 1 ? argv + 1 : default_files;
+	size_t files_size = argc > 1 ? (size_t)(argc - 1) : sizeof(default_files) / sizeof(default_files[0]);
+
+	if (gp_init_render(SAMPLE_RATE) != GP_RESULT_OK) {
+		fprintf(stderr, "[ERROR]: could not initialise the render mode\n");
+		return 1;
+	}
+
+	printf("{\n  \"sample_rate\": %d,\n", SAMPLE_RATE);
+	bench_decode(files, files_size);
+	bench_seek(files);
+	bench_seek_index(files[0]);
+	bench_skip_to(files, files_size);
+	bench_set_sources(files[0]);
+	bench_source_list(files[0]);
+	bench_metadata_cache(files, files_size);
+	bench_scan(files, files_size);
+	bench_gain();
+	bench_loudness(files, files_size);
+	bench_tap();
+	bench_players(files, files_size);
+	bench_handover(files, files_size);
+	gp_close();
+
+	bench_cold_start(files[0]);
+	printf("}\n");
+
+	return 0;
+}
@@ -0,0 +1,132 @@
+#include <stdatomic.h>
+#include <stdio.h>
+#include <threads.h>
+#include "utils.h"
+#include "grass_player.h"
+
+#define STRESS_THREADS 4
+#define STRESS_ITERATIONS 5000
+#define RENDER_BLOCK_FRAMES 1024
+#define SPECTRUM_SIZE 512
+
+int tests_run = 0;
+
+const char* playlist[] = {
+		CONCAT(PROJECT_TEST_DIR, "/sample-files/01_Ghosts_I.flac"),
+		CONCAT(PROJECT_TEST_DIR, "/sample-files/24_Ghosts_III.flac"),
+		CONCAT(PROJECT_TEST_DIR, "/sample-files/25_Ghosts_III.flac")
+};
+
+const size_t playlist_size = sizeof(playlist) / sizeof(playlist[0]);
+
+static atomic_bool rendering;
+
+static uint32_t next_random(uint32_t* state) {
+	*state ^= *state << 13;
+	*state ^= *state >> 17;
+	*state ^= *state << 5;
+	return *state;
+}
+
+static int run_api_thread(void* arg) {
+	uint32_t state = (uint32_t)(uintptr_t)arg;
+	float pcm[RENDER_BLOCK_FRAMES * 2];
+	float magnitudes[SPECTRUM_SIZE];
+	struct GpLevels levels;
+	struct GpOutputConfig config;
+
+	for (size_t i = 0; i < STRESS_ITERATIONS; i++) {
+		size_t sources_size = gp_get_sources_size();
+		size_t index = sources_size > 0 ? next_random(&state) % sources_size : 0;
+
+		switch (next_random(&state) % 12) {
+		case 0: gp_append_sources(playlist, playlist_size);
+			break;
+		case 1: gp_insert_sources(index, playlist + 1, 1);
+			break;
+		case 2: gp_remove_sources(index, 1);
+			break;
+		case 3: gp_move_source(index, sources_size > 0 ? next_random(&state) % sources_size : 0);
+			break;
+		case 4: gp_skip_to(index);
+			break;
+		case 5: gp_seek((double)(next_random(&state) % 120));
+			break;
+		case 6: gp_set_volume((float)(next_random(&state) % 100) / 100.0f);
+			break;
+		case 7: gp_play();
+			break;
+		case 8: gp_get_source_position();
+			gp_get_source_duration();
+			gp_get_source_index();
+			break;
+		case 9: gp_get_source_path();
+			gp_get_playback_state();
+			break;
+		case 10: gp_get_pcm(pcm, RENDER_BLOCK_FRAMES);
+			gp_get_levels(RENDER_BLOCK_FRAMES, &levels);
+			gp_get_spectrum(magnitudes, SPECTRUM_SIZE);
+			break;
+		case 11: gp_get_output_config(&config);
+			break;
+		}
+	}
+
+	return 0;
+}
+
+static int run_render_thread(void* arg) {
+	(void)arg;
+	static float buffer[RENDER_BLOCK_FRAMES * 2];
+
+	while (atomic_load(&rendering)) {
+		gp_render(buffer, RENDER_BLOCK_FRAMES);
+	}
+
+	return 0;
+}
+
+TEST(concurrent_api, {
+	ASSERT("init render", gp_init_render(GP_SAMPLE_RATE_44100) == GP_RESULT_OK);
+
+	gp_set_sources(playlist, playlist_size);
+	gp_play();
+
+	atomic_store(&rendering, true);
+	thrd_t render_thread;
+	ASSERT("render thread should start", thrd_create(&render_thread, run_render_thread, NULL) == thrd_success);
+
+	thrd_t api_threads[STRESS_THREADS];
+	for (size_t i = 0; i < STRESS_THREADS; i++) {
+		ASSERT("api thread should start",
+				thrd_create(&api_threads[i], run_api_thread, (void*)(uintptr_t)(i * 7919 + 1)) == thrd_success);
+	}
+
+	for (size_t i = 0; i < STRESS_THREADS; i++) thrd_join(api_threads[i], NULL);
+
+	atomic_store(&rendering, false);
+	thrd_join(render_thread, NULL);
+
+	gp_flush();
+	ASSERT("source index should be in range",
+			gp_get_sources_size() == 0 || gp_get_source_index() < gp_get_sources_size());
+
+	ASSERT("close", gp_close() == GP_RESULT_OK);
+})
+
+static char* all_tests(void) {
+	RUN_TEST(concurrent_api);
+	return 0;
+}
+
+int main(void) {
+	char* result = all_tests();
+	if (result != 0) {
+		printf("[ERROR]: %s\n", result);
+	}
+	else {
+		printf("ALL TESTS PASSED\n");
+	}
+	printf("Tests run: %d\n", tests_run);
+	return result != 0;
+}
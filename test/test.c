@@ -1,7 +1,13 @@
-#include <windows.h>
+#include <math.h>
 #include <stdio.h>
+#include <string.h>
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
 #include "utils.h"
 #include "grass_player.h"
+#include "gp_gain.h"
 
 #define TIME_DELTA 1
 
@@ -15,11 +21,43 @@ const char* playlist[] = {
 
 const uint16_t playlist_size = sizeof(playlist) / sizeof(playlist[0]);
 
+static const size_t kernel_frame_counts[] = {1, 3, 7, 31, 33, 63, 65, 127};
+
 TEST(basic, {
 	ASSERT("init", gp_init(GP_SAMPLE_RATE_44100) == GP_RESULT_OK);
 	ASSERT("close", gp_close() == GP_RESULT_OK);
 })
 
+TEST(missing_plugin, {
+	ASSERT("set plugin path", gp_set_plugin_path(CONCAT(PROJECT_TEST_DIR, "/missing-plugins")) == GP_RESULT_OK);
+	ASSERT("init should not need plugins", gp_init(GP_SAMPLE_RATE_44100) == GP_RESULT_OK);
+	gp_set_sources(playlist, 1);
+	gp_flush();
+	ASSERT("sources should still be queued", gp_get_sources_size() == 1);
+	ASSERT("close", gp_close() == GP_RESULT_OK);
+	ASSERT("reset plugin path", gp_set_plugin_path(NULL) == GP_RESULT_OK);
+})
+
+TEST(init_stats, {
+	ASSERT("init", gp_init(GP_SAMPLE_RATE_44100) == GP_RESULT_OK);
+
+	struct GpInitStats stats;
+	ASSERT("get init stats", gp_get_init_stats(&stats) == GP_RESULT_OK);
+	ASSERT("phases should fit in init", stats.device_init_seconds + stats.mixer_create_seconds
+			+ stats.sync_setup_seconds <= stats.init_seconds);
+	ASSERT("first audio should wait for play", stats.first_audio_seconds == 0);
+
+	gp_set_sources(playlist, 1);
+	gp_play();
+	gp_flush();
+	Sleep(1000);
+	gp_get_init_stats(&stats);
+	ASSERT("first audio should be recorded", stats.first_audio_seconds > 0 && stats.first_audio_seconds < 1);
+	ASSERT("flac plugin load should be timed", stats.plugin_load_seconds > 0);
+
+	ASSERT("close", gp_close() == GP_RESULT_OK);
+})
+
 TEST(basic_playback, {
 	gp_init(GP_SAMPLE_RATE_44100);
 
@@ -108,6 +146,10 @@ TEST(basic_playlist_playback, {
 
 	ASSERT("source index should be 2", gp_get_source_index() == 2);
 
+	struct GpHandoverStats handover_stats;
+	ASSERT("handover stats should be available", gp_get_handover_stats(&handover_stats) == GP_RESULT_OK);
+	ASSERT("next source should be preloaded", handover_stats.preloaded);
+
 	gp_close();
 })
 
@@ -139,12 +181,566 @@ TEST(playlist_end, {
 
 })
 
+TEST(latency_profiles, {
+	struct GpInitOptions options;
+	options.sample_rate = GP_SAMPLE_RATE_44100;
+	options.output_mode = GP_OUTPUT_MODE_DEVICE;
+	options.latency_profile = GP_LATENCY_PROFILE_LOW_LATENCY;
+	ASSERT("init low latency", gp_init_ex(&options) == GP_RESULT_OK);
+
+	struct GpOutputConfig low_latency_config;
+	gp_get_output_config(&low_latency_config);
+	ASSERT("low latency update period should be 5 ms", low_latency_config.update_period_ms == 5);
+	gp_close();
+
+	options.latency_profile = GP_LATENCY_PROFILE_POWER_SAVING;
+	gp_init_ex(&options);
+	struct GpOutputConfig power_saving_config;
+	gp_get_output_config(&power_saving_config);
+	ASSERT("power saving buffer should be larger", power_saving_config.buffer_ms > low_latency_config.buffer_ms);
+	gp_close();
+
+	options.latency_profile = GP_LATENCY_PROFILE_CALIBRATED;
+	ASSERT("init calibrated", gp_init_ex(&options) == GP_RESULT_OK);
+	struct GpOutputConfig calibrated_config;
+	gp_get_output_config(&calibrated_config);
+	ASSERT("calibrated buffer should cover the update period",
+			calibrated_config.buffer_ms > calibrated_config.update_period_ms);
+	gp_close();
+
+	ASSERT("init calibrated again", gp_init_ex(&options) == GP_RESULT_OK);
+	struct GpOutputConfig cached_config;
+	gp_get_output_config(&cached_config);
+	ASSERT("calibration should be reused", cached_config.buffer_ms == calibrated_config.buffer_ms);
+	struct GpInitStats init_stats;
+	gp_get_init_stats(&init_stats);
+	ASSERT("reused calibration should not block init",
+			init_stats.init_seconds - init_stats.device_init_seconds < 0.5);
+	gp_close();
+})
+
+TEST(native_rate, {
+	struct GpInitOptions options;
+	options.sample_rate = 96000;
+	options.output_mode = GP_OUTPUT_MODE_NATIVE_RATE;
+	options.latency_profile = GP_LATENCY_PROFILE_BALANCED;
+	ASSERT("init native rate", gp_init_ex(&options) == GP_RESULT_OK);
+
+	struct GpOutputConfig config;
+	gp_get_output_config(&config);
+	ASSERT("output should start at the requested rate", config.sample_rate == 96000);
+
+	gp_set_sources(playlist, 2);
+	gp_play();
+	gp_flush();
+
+	struct GpSourceInfo info;
+	gp_get_source_info(0, &info);
+	gp_get_output_config(&config);
+	ASSERT("output should follow the source rate", config.sample_rate == info.sample_rate);
+	ASSERT("playback should continue after the rate change", gp_get_playback_state() == GP_PLAYBACK_STATE_PLAYING);
+
+	gp_skip_to(1);
+	gp_flush();
+	ASSERT("skip should keep playing", gp_get_playback_state() == GP_PLAYBACK_STATE_PLAYING);
+
+	gp_close();
+})
+
+TEST(zones, {
+	struct GpInitOptions options;
+	options.sample_rate = GP_SAMPLE_RATE_44100;
+	options.output_mode = GP_OUTPUT_MODE_ZONES;
+	options.latency_profile = GP_LATENCY_PROFILE_BALANCED;
+	ASSERT("init zones", gp_init_ex(&options) == GP_RESULT_OK);
+
+	ASSERT("add main zone", gp_add_zone(-1) == GP_RESULT_OK);
+	ASSERT("add monitor zone", gp_add_zone(-1) == GP_RESULT_OK);
+	ASSERT("zones size should be 2", gp_get_zones_size() == 2);
+	ASSERT("set zone gain", gp_set_zone_gain(1, 0.5f) == GP_RESULT_OK);
+	ASSERT("set zone latency offset", gp_set_zone_latency_offset(1, 200) == GP_RESULT_OK);
+	ASSERT("unknown zone should fail", gp_set_zone_gain(2, 0.5f) == GP_RESULT_ERROR);
+
+	gp_set_sources(playlist, 1);
+	gp_play();
+	gp_flush();
+	ASSERT("zones should be playing", gp_get_playback_state() == GP_PLAYBACK_STATE_PLAYING);
+	Sleep(2000);
+	ASSERT("position should advance through the zones", gp_get_source_position() > 1);
+
+	ASSERT("remove zone", gp_remove_zone(0) == GP_RESULT_OK);
+	gp_flush();
+	ASSERT("zones size should be 1", gp_get_zones_size() == 1);
+	gp_pause();
+	gp_flush();
+	ASSERT("zones should be paused", gp_get_playback_state() == GP_PLAYBACK_STATE_PAUSED);
+
+	gp_close();
+})
+
+#ifndef _WIN32
+TEST(sink, {
+	struct GpInitOptions options;
+	options.sample_rate = GP_SAMPLE_RATE_44100;
+	options.output_mode = GP_OUTPUT_MODE_SINK;
+	options.latency_profile = GP_LATENCY_PROFILE_BALANCED;
+	ASSERT("init sink", gp_init_ex(&options) == GP_RESULT_OK);
+
+	const char* file_path = CONCAT(PROJECT_TEST_DIR, "/sink.txt");
+	FILE* file = fopen(file_path, "w");
+	ASSERT("create regular file", file != NULL);
+	fclose(file);
+	ASSERT("sink should refuse a regular file", gp_open_sink(file_path, GP_SINK_FORMAT_S16) == GP_RESULT_ERROR);
+	ASSERT("regular file should be kept", remove(file_path) == 0);
+
+	const char* path = CONCAT(PROJECT_TEST_DIR, "/sink.sock");
+	ASSERT("open sink", gp_open_sink(path, GP_SINK_FORMAT_S16) == GP_RESULT_OK);
+	ASSERT("second sink should fail", gp_open_sink(path, GP_SINK_FORMAT_S16) == GP_RESULT_ERROR);
+
+	int client = socket(AF_UNIX, SOCK_STREAM, 0);
+	struct sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strncpy(address.sun_path, path, sizeof(address.sun_path) - 1);
+	ASSERT("connect to sink", connect(client, (struct sockaddr*)&address, sizeof(address)) == 0);
+
+	gp_set_sources(playlist, 1);
+	gp_play();
+	gp_flush();
+	ASSERT("sink should be playing", gp_get_playback_state() == GP_PLAYBACK_STATE_PLAYING);
+
+	char buffer[44100 * 4];
+	size_t received = 0;
+	while (received < sizeof(buffer)) {
+		ssize_t size = recv(client, buffer + received, sizeof(buffer) - received, 0);
+		if (size <= 0) break;
+		received += (size_t)size;
+	}
+	ASSERT("sink should stream a second of s16 frames", received == sizeof(buffer));
+
+	struct GpSinkStats stats;
+	ASSERT("get sink stats", gp_get_sink_stats(&stats) == GP_RESULT_OK);
+	ASSERT("sink should have one client", stats.clients == 1 && stats.dropped_clients == 0);
+	close(client);
+
+	gp_close();
+})
+#endif
+
+TEST(render, {
+	ASSERT("init render", gp_init_render(GP_SAMPLE_RATE_44100) == GP_RESULT_OK);
+
+	gp_set_position_interval(0);
+	gp_set_sources(playlist, 1);
+	gp_play();
+
+	float buffer[44100 * 2];
+	ASSERT("render should produce a full second", gp_render(buffer, 44100) == 44100);
+
+	struct GpSnapshot snapshot;
+	ASSERT("snapshot should be available", gp_get_snapshot(&snapshot) == GP_RESULT_OK);
+	ASSERT("snapshot should hold the current source", snapshot.source_index == 0 && snapshot.sources_size == 1);
+	ASSERT("snapshot position should be around 1", snapshot.source_position - 1 < TIME_DELTA);
+	ASSERT("snapshot duration should match the source", snapshot.source_duration == gp_get_source_duration());
+
+	gp_seek(110);
+	size_t frames_size = 0;
+	size_t rendered_size;
+	while ((rendered_size = gp_render(buffer, 44100)) > 0) frames_size += rendered_size;
+	ASSERT("render should stop at the end of the queue", frames_size > 0);
+	ASSERT("render should be empty after the queue ends", gp_render(buffer, 44100) == 0);
+
+	bool track_changed = false;
+	bool seek_completed = false;
+	bool queue_ended = false;
+	struct GpEvent event;
+	while (gp_poll_event(&event)) {
+		if (event.type == GP_EVENT_TYPE_TRACK_CHANGED) track_changed = true;
+		if (event.type == GP_EVENT_TYPE_SEEK_COMPLETED) seek_completed = event.position - 110 < TIME_DELTA;
+		if (event.type == GP_EVENT_TYPE_QUEUE_ENDED) queue_ended = true;
+	}
+	ASSERT("track changed event should be posted", track_changed);
+	ASSERT("seek completed event should be posted", seek_completed);
+	ASSERT("queue ended event should be posted", queue_ended);
+
+	gp_close();
+})
+
+TEST(audible_position, {
+	gp_init_render(GP_SAMPLE_RATE_44100);
+	gp_set_sources(playlist, 1);
+	gp_play();
+
+	float buffer[4096 * 2];
+	for (size_t i = 0; i < 100; i++) gp_render(buffer, 4410);
+	ASSERT("position should count rendered frames", gp_get_source_position_frames() == 10 * 44100);
+	ASSERT("position in seconds should match the frame count", fabs(gp_get_source_position() - 10) < 1e-6);
+
+	struct GpInitOptions options;
+	options.sample_rate = GP_SAMPLE_RATE_44100;
+	options.output_mode = GP_OUTPUT_MODE_RENDER;
+	options.latency_profile = GP_LATENCY_PROFILE_BALANCED;
+
+	struct GpPlayer* reference = gp_player_create(&options);
+	ASSERT("create reference player", reference != NULL);
+	gp_player_set_sources(reference, playlist, 1);
+	gp_player_play(reference);
+	gp_player_seek(reference, 10);
+	gp_player_flush(reference);
+
+	float reference_buffer[4096 * 2];
+	gp_render(buffer, 4096);
+	gp_player_render(reference, reference_buffer, 4096);
+	float peak = 0;
+	float difference = 0;
+	for (size_t i = 512 * 2; i < 4096 * 2; i++) {
+		peak = fmaxf(peak, fabsf(buffer[i]));
+		difference = fmaxf(difference, fabsf(buffer[i] - reference_buffer[i]));
+	}
+	ASSERT("rendered audio should not be silent", peak > 1e-3f);
+	ASSERT("rendered audio should be the source at the reported position", difference < 1e-4f);
+	ASSERT("destroy reference player", gp_player_destroy(reference) == GP_RESULT_OK);
+
+	gp_seek(10);
+	gp_flush();
+	gp_render(buffer, 4096);
+	ASSERT("position should follow a seek", gp_get_source_position_frames() == 10 * 44100 + 4096);
+
+	gp_close();
+})
+
+TEST(multiple_players, {
+	struct GpInitOptions options;
+	options.sample_rate = GP_SAMPLE_RATE_44100;
+	options.output_mode = GP_OUTPUT_MODE_RENDER;
+	options.latency_profile = GP_LATENCY_PROFILE_BALANCED;
+
+	struct GpPlayer* first = gp_player_create(&options);
+	struct GpPlayer* second = gp_player_create(&options);
+	ASSERT("create players", first != NULL && second != NULL);
+	ASSERT("default player should still init", gp_init_render(GP_SAMPLE_RATE_44100) == GP_RESULT_OK);
+
+	gp_player_set_sources(first, playlist, 1);
+	gp_player_set_sources(second, playlist + 1, 2);
+	gp_player_play(first);
+	gp_player_play(second);
+	gp_player_seek(second, 10);
+	gp_player_flush(second);
+
+	float buffer[4096 * 2];
+	ASSERT("first player should render", gp_player_render(first, buffer, 4096) == 4096);
+	ASSERT("second player should render", gp_player_render(second, buffer, 4096) == 4096);
+	ASSERT("players should keep separate queues",
+			gp_player_get_sources_size(first) == 1 && gp_player_get_sources_size(second) == 2);
+	ASSERT("players should keep separate positions", gp_player_get_source_position_frames(first) == 4096
+			&& gp_player_get_source_position_frames(second) == 10 * 44100 + 4096);
+	ASSERT("default player should be empty", gp_get_sources_size() == 0);
+
+	ASSERT("destroy first player", gp_player_destroy(first) == GP_RESULT_OK);
+	ASSERT("second player should outlive the first", gp_player_render(second, buffer, 4096) == 4096);
+	ASSERT("destroy second player", gp_player_destroy(second) == GP_RESULT_OK);
+	ASSERT("close default player", gp_close() == GP_RESULT_OK);
+})
+
+TEST(gain, {
+	gp_init_render(GP_SAMPLE_RATE_44100);
+
+	gp_set_sources(playlist, 2);
+	gp_set_volume(0.5f);
+	gp_set_replay_gain_mode(GP_REPLAY_GAIN_MODE_TRACK);
+	gp_play();
+	gp_skip_to(1);
+	gp_flush();
+	ASSERT("volume should persist across sources", gp_get_volume() == 0.5f);
+
+	float buffer[44100 * 2];
+	gp_render(buffer, 44100);
+	float peak = 0;
+	for (size_t i = 0; i < 44100 * 2; i++) {
+		if (buffer[i] > peak) peak = buffer[i];
+		if (-buffer[i] > peak) peak = -buffer[i];
+	}
+	ASSERT("limiter should keep the output under the ceiling", peak < 0.9f);
+
+	gp_set_volume(0);
+	gp_render(buffer, 44100);
+	ASSERT("muted output should be silent after the ramp", buffer[44100 * 2 - 1] == 0);
+
+	gp_close();
+})
+
+TEST(gain_limiter, {
+	static struct GpGainStage stage;
+	gp_gain_stage_init(&stage, GP_SAMPLE_RATE_44100);
+	gp_gain_stage_set_source_gain(&stage, 2);
+
+	static float buffer[GP_GAIN_CHUNK_FRAMES * 64 * GP_GAIN_CHANNELS];
+	size_t frames = GP_GAIN_CHUNK_FRAMES * 64;
+	for (size_t i = 0; i < frames * GP_GAIN_CHANNELS; i++) buffer[i] = i % 4 < 2 ? 1.0f : -1.0f;
+
+	for (size_t offset = 0; offset < frames; offset += 37) {
+		size_t size = frames - offset < 37 ? frames - offset : 37;
+		gp_gain_stage_process(&stage, buffer + offset * GP_GAIN_CHANNELS, size);
+	}
+
+	ASSERT("output should not be delayed", buffer[0] != 0 && buffer[GP_GAIN_CHANNELS] != 0);
+
+	float peak = 0;
+	for (size_t i = 0; i < frames * GP_GAIN_CHANNELS; i++) {
+		if (fabsf(buffer[i]) > peak) peak = fabsf(buffer[i]);
+	}
+	ASSERT("limiter should keep above unity input under the ceiling", peak <= GP_LIMITER_CEILING);
+	ASSERT("limiter should not silence the output", peak > GP_LIMITER_CEILING / 2);
+})
+
+TEST(gain_kernels, {
+	const char* kernel_name = NULL;
+	GpGainKernel kernel = gp_gain_select_kernel(&kernel_name);
+	INFO(kernel_name);
+
+	float source[128 * GP_GAIN_CHANNELS];
+	float expected[128 * GP_GAIN_CHANNELS];
+	float actual[128 * GP_GAIN_CHANNELS];
+	for (size_t i = 0; i < 128 * GP_GAIN_CHANNELS; i++) source[i] = sinf((float)i * 0.37f) * 1.5f;
+
+	for (size_t i = 0; i < sizeof(kernel_frame_counts) / sizeof(kernel_frame_counts[0]); i++) {
+		size_t frames = kernel_frame_counts[i];
+		for (size_t j = 0; j < 128 * GP_GAIN_CHANNELS; j++) actual[j] = 7;
+
+		float expected_peak = gp_gain_apply_scalar(source, expected, frames, 0.5f, 0.001f);
+		float actual_peak = kernel(source, actual, frames, 0.5f, 0.001f);
+
+		float error = fabsf(actual_peak - expected_peak);
+		for (size_t j = 0; j < frames * GP_GAIN_CHANNELS; j++) {
+			if (fabsf(actual[j] - expected[j]) > error) error = fabsf(actual[j] - expected[j]);
+		}
+		ASSERT("kernel should match the scalar kernel", error <= 1e-6f);
+		ASSERT("kernel should not write past the last frame", actual[frames * GP_GAIN_CHANNELS] == 7);
+	}
+})
+
+TEST(visualizer_tap, {
+	gp_init_render(GP_SAMPLE_RATE_44100);
+
+	float frames[1024 * 2];
+	ASSERT("tap should be empty before rendering", gp_get_pcm(frames, 1024) == GP_RESULT_ERROR);
+
+	gp_set_sources(playlist, 1);
+	gp_play();
+
+	float buffer[4096 * 2];
+	gp_render(buffer, 4096);
+	ASSERT("get pcm", gp_get_pcm(frames, 1024) == GP_RESULT_OK);
+	ASSERT("tap should hold the latest rendered frames", memcmp(frames, buffer + 3072 * 2, sizeof(frames)) == 0);
+
+	struct GpLevels levels;
+	ASSERT("get levels", gp_get_levels(4096, &levels) == GP_RESULT_OK);
+	ASSERT("rms should not exceed peak", levels.rms[0] <= levels.peak[0] && levels.rms[1] <= levels.peak[1]);
+
+	float magnitudes[512];
+	ASSERT("get spectrum", gp_get_spectrum(magnitudes, 512) == GP_RESULT_OK);
+	ASSERT("spectrum size should be a power of two", gp_get_spectrum(magnitudes, 500) == GP_RESULT_ERROR);
+
+	gp_close();
+})
+
+TEST(crossfade, {
+	gp_init_render(GP_SAMPLE_RATE_44100);
+
+	gp_set_position_interval(0);
+	gp_set_crossfade(2);
+	gp_set_sources(playlist, 2);
+	gp_play();
+	gp_flush();
+
+	gp_seek(gp_get_source_duration() - 3);
+
+	float buffer[44100 * 2];
+	gp_render(buffer, 44100);
+	gp_render(buffer, 44100);
+	ASSERT("crossfade should switch to the next source before the end", gp_get_source_index() == 1);
+
+	size_t track_changes = 0;
+	struct GpEvent event;
+	while (gp_poll_event(&event)) {
+		if (event.type == GP_EVENT_TYPE_TRACK_CHANGED) track_changes++;
+	}
+	ASSERT("track changed event should be posted for each source", track_changes == 2);
+
+	gp_close();
+})
+
+TEST(queue_editing, {
+	gp_init_render(GP_SAMPLE_RATE_44100);
+
+	gp_set_sources(playlist, 1);
+	gp_play();
+
+	ASSERT("append", gp_append_sources(playlist + 1, 2) == GP_RESULT_OK);
+	gp_flush();
+	ASSERT("sources size should be 3", gp_get_sources_size() == 3);
+	ASSERT("source index should be 0", gp_get_source_index() == 0);
+
+	ASSERT("insert", gp_insert_sources(0, playlist + 2, 1) == GP_RESULT_OK);
+	gp_flush();
+	ASSERT("source index should follow the current source", gp_get_source_index() == 1);
+
+	ASSERT("move", gp_move_source(1, 3) == GP_RESULT_OK);
+	gp_flush();
+	ASSERT("source index should follow the moved source", gp_get_source_index() == 3);
+	ASSERT("current source path should be kept", strcmp(gp_get_source_path(), playlist[0]) == 0);
+
+	ASSERT("remove", gp_remove_sources(0, 2) == GP_RESULT_OK);
+	gp_flush();
+	ASSERT("sources size should be 2", gp_get_sources_size() == 2);
+	ASSERT("source index should be 1", gp_get_source_index() == 1);
+	ASSERT("playback state should be playing",
+			gp_get_playback_state() == GP_PLAYBACK_STATE_PLAYING);
+
+	ASSERT("remove out of range", gp_remove_sources(1, 2) == GP_RESULT_ERROR);
+
+	gp_close();
+})
+
+TEST(metadata_cache, {
+	const char* cache_path = CONCAT(PROJECT_TEST_DIR, "/metadata.cache");
+	remove(cache_path);
+
+	gp_init_render(GP_SAMPLE_RATE_44100);
+	ASSERT("open metadata cache", gp_open_metadata_cache(cache_path) == GP_RESULT_OK);
+	gp_set_sources(playlist, playlist_size);
+	gp_flush();
+
+	struct GpSourceInfo probed_info;
+	ASSERT("source info should be probed", gp_get_source_info(2, &probed_info) == GP_RESULT_OK);
+	ASSERT("source duration should be known without a stream", probed_info.duration > 0);
+	ASSERT("source codec should be flac", probed_info.codec == GP_CODEC_FLAC);
+	ASSERT("out of range source info", gp_get_source_info(playlist_size, &probed_info) == GP_RESULT_ERROR);
+	gp_close();
+
+	gp_init_render(GP_SAMPLE_RATE_44100);
+	gp_open_metadata_cache(cache_path);
+	gp_set_sources(playlist, playlist_size);
+	gp_flush();
+
+	struct GpSourceInfo cached_info;
+	ASSERT("source info should be cached", gp_get_source_info(2, &cached_info) == GP_RESULT_OK);
+	ASSERT("cached source info should match", cached_info.duration == probed_info.duration
+			&& cached_info.sample_rate == probed_info.sample_rate
+			&& cached_info.channels == probed_info.channels);
+	gp_close();
+
+	remove(cache_path);
+})
+
+TEST(seek_index, {
+	const char* cache_path = CONCAT(PROJECT_TEST_DIR, "/seek.cache");
+	remove(cache_path);
+
+	float buffer[4096 * 2];
+	gp_init_render(GP_SAMPLE_RATE_44100);
+	gp_open_metadata_cache(cache_path);
+	gp_set_sources(playlist, 1);
+	gp_play();
+	while (gp_render(buffer, 4096) > 0) continue;
+	gp_close();
+
+	gp_init_render(GP_SAMPLE_RATE_44100);
+	gp_open_metadata_cache(cache_path);
+	gp_set_source_mode(GP_SOURCE_MODE_MAPPED);
+	gp_set_sources(playlist, 1);
+	gp_play();
+	gp_render(buffer, 4096);
+	ASSERT("indexed source should decode", fabs(gp_get_source_position() - 4096.0 / 44100) < TIME_DELTA);
+
+	gp_seek(60);
+	gp_flush();
+	ASSERT("indexed source position should be around 60", fabs(gp_get_source_position() - 60) < TIME_DELTA);
+	ASSERT("indexed source should decode after the seek", gp_render(buffer, 4096) == 4096);
+	gp_close();
+
+	remove(cache_path);
+})
+
+const char* scan_paths[] = {
+		CONCAT(PROJECT_TEST_DIR, "/sample-files/01_Ghosts_I.flac"),
+		CONCAT(PROJECT_TEST_DIR, "/sample-files/24_Ghosts_III.flac"),
+		CONCAT(PROJECT_TEST_DIR, "/sample-files/25_Ghosts_III.flac"),
+		CONCAT(PROJECT_TEST_DIR, "/sample-files/missing.flac")
+};
+
+static void collect_scan_results(const struct GpScanResult* results, size_t results_size, void* user) {
+	struct GpScanResult* collected = user;
+	for (size_t i = 0; i < results_size; i++) collected[results[i].index] = results[i];
+}
+
+TEST(library_scan, {
+	gp_init_render(GP_SAMPLE_RATE_44100);
+
+	struct GpScanResult results[4] = {0};
+	ASSERT("scan", gp_scan(scan_paths, 4, 0, collect_scan_results, results) == GP_RESULT_OK);
+	ASSERT("existing sources should be valid", results[0].valid && results[1].valid && results[2].valid);
+	ASSERT("scanned duration should be known", results[2].info.duration > 0);
+	ASSERT("missing source should be invalid", !results[3].valid && results[3].index == 3);
+
+	gp_close();
+})
+
+static void collect_analysis_results(const struct GpAnalysisResult* results, size_t results_size, void* user) {
+	struct GpAnalysisResult* collected = user;
+	for (size_t i = 0; i < results_size; i++) collected[results[i].index] = results[i];
+}
+
+TEST(loudness_analysis, {
+	gp_init_render(GP_SAMPLE_RATE_44100);
+	gp_set_sources(scan_paths, 3);
+	gp_flush();
+
+	struct GpLoudnessInfo loudness;
+	ASSERT("loudness should not be known before analysis", gp_get_source_loudness(0, &loudness) == GP_RESULT_ERROR);
+
+	struct GpAnalysisResult results[4] = {0};
+	ASSERT("analyze", gp_analyze(scan_paths, 4, 0, collect_analysis_results, results) == GP_RESULT_OK);
+	ASSERT("existing sources should be valid", results[0].valid && results[1].valid && results[2].valid);
+	ASSERT("integrated loudness should be below full scale", results[2].loudness.integrated_loudness < 0);
+	ASSERT("true peak should not be below integrated loudness",
+			results[2].loudness.true_peak >= results[2].loudness.integrated_loudness);
+	ASSERT("missing source should be invalid", !results[3].valid && results[3].index == 3);
+
+	ASSERT("loudness should be cached", gp_get_source_loudness(2, &loudness) == GP_RESULT_OK);
+	ASSERT("cached loudness should match",
+			fabs(loudness.integrated_loudness - results[2].loudness.integrated_loudness) < 0.01);
+
+	gp_close();
+})
+
 static char* all_tests(void) {
 	RUN_TEST(basic);
+	RUN_TEST(missing_plugin);
+	RUN_TEST(init_stats);
 	RUN_TEST(basic_playback);
 	RUN_TEST(seek);
 	RUN_TEST(basic_playlist_playback);
 	RUN_TEST(playlist_end);
+	RUN_TEST(latency_profiles);
+	RUN_TEST(native_rate);
+	RUN_TEST(zones);
+#ifndef _WIN32
+	RUN_TEST(sink);
+#endif
+	RUN_TEST(render);
+	RUN_TEST(audible_position);
+	RUN_TEST(multiple_players);
+	RUN_TEST(gain);
+	RUN_TEST(gain_limiter);
+	RUN_TEST(gain_kernels);
+	RUN_TEST(visualizer_tap);
+	RUN_TEST(crossfade);
+	RUN_TEST(queue_editing);
+	RUN_TEST(metadata_cache);
+	RUN_TEST(seek_index);
+	RUN_TEST(library_scan);
+	RUN_TEST(loudness_analysis);
 	return 0;
 }
 
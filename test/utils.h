@@ -1,5 +1,11 @@
 #pragma once
 #include <stdio.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#define Sleep(ms) usleep((ms) * 1000)
+#endif
 
 #define ASSERT(message, test) do {if ((test)){printf("[OK] %s\n",message);} else {return message;}} while (0)
 